@@ -0,0 +1,1085 @@
+/**
+ * Benchmarks.cpp
+ * Defines the engine's built-in microbenchmarks, run from
+ * the command line with --bench.
+ */
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Components.h"
+#include "Jobs.h"
+#include "LightClusters.h"
+#include "LightSelection.h"
+#include "Prototypes.h"
+#include "SpatialGrid.h"
+#include "Systems.h"
+
+#include "procedural_generation/procedural_generation.h"
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	//Times the given function, returning seconds taken
+	template <typename F>
+	double timed(const F &f)
+	{
+		auto start = clock::now();
+		f();
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	//Has any check made by the benchmarks run so far failed?
+	bool failed = false;
+
+	//Reports the outcome of a check, remembering failures so the run ends unsuccessfully
+	void check(bool ok, const std::string &what)
+	{
+		std::cout << "  " << (ok ? "passed: " : "FAILED: ") << what << std::endl;
+		failed = failed || !ok;
+	}
+
+	//Throughput of the job system: spawning, nesting and parallel loops
+	void bench_jobs()
+	{
+		using namespace game;
+
+		std::cout << "jobs: " << jobs::worker_count() << " workers" << std::endl;
+
+		//Many empty jobs in one group
+		const size_t N_EMPTY = 200000;
+		double t = timed([&] {
+			jobs::Counter c;
+			for (size_t i = 0; i < N_EMPTY; i++)
+				jobs::run([] {}, &c);
+			jobs::wait(c);
+		});
+		std::cout << "  empty jobs:    " << N_EMPTY / t / 1e6 << "M jobs/s" << std::endl;
+
+		//Parents each spawning children into their group
+		const size_t N_PARENTS = 1000, N_CHILDREN = 100;
+		std::atomic<size_t> ran{ 0 };
+		t = timed([&] {
+			jobs::Counter c;
+			for (size_t i = 0; i < N_PARENTS; i++)
+				jobs::run([&ran] {
+					for (size_t j = 0; j < N_CHILDREN; j++)
+						jobs::run([&ran] { ran++; });
+				}, &c);
+			jobs::wait(c);
+		});
+		std::cout << "  nested jobs:   " << N_PARENTS * N_CHILDREN / t / 1e6 << "M jobs/s ("
+			<< ran << " ran)" << std::endl;
+
+		//Data-parallel loop against the serial equivalent
+		const size_t N_ITEMS = 1 << 22;
+		std::vector<double> data(N_ITEMS);
+		auto work = [&data](size_t i) { data[i] = std::sqrt(double(i)) * std::sin(double(i)); };
+
+		double t_serial = timed([&] {
+			for (size_t i = 0; i < N_ITEMS; i++)
+				work(i);
+		});
+		double t_parallel = timed([&] { jobs::parallel_for(0, N_ITEMS, 4096, work); });
+		std::cout << "  parallel_for:  " << t_serial * 1000 << "ms serial, " << t_parallel * 1000
+			<< "ms parallel (x" << t_serial / t_parallel << ")" << std::endl;
+
+		//Kinematic integration over an entt view against view.each
+		const size_t N_ENTITIES = 100000;
+		const double dt = 1.0 / GAME_RATE;
+		entt::registry<> reg;
+		for (size_t i = 0; i < N_ENTITIES; i++)
+		{
+			auto e = reg.create();
+			reg.assign<TransformComponent>(e);
+			reg.assign<KinematicComponent>(e).acceleration = { 0, -9.8, 0 };
+		}
+
+		auto integrate = [dt](auto, TransformComponent &t, KinematicComponent &k) {
+			k.velocity_old = k.velocity;
+			k.velocity += k.acceleration * dt;
+			t.position += (k.velocity + k.velocity_old) / 2.0 * dt;
+		};
+
+		t_serial = timed([&] { reg.view<TransformComponent, KinematicComponent>().each(integrate); });
+		t_parallel = timed([&] { jobs::parallel_for_each<TransformComponent, KinematicComponent>(reg, 1024, integrate); });
+		std::cout << "  view each:     " << t_serial * 1000 << "ms serial, " << t_parallel * 1000
+			<< "ms parallel (x" << t_serial / t_parallel << ")" << std::endl;
+	}
+
+	namespace legacy
+	{
+		using namespace game;
+
+		//The former per-entity type-erased system function
+		template <typename... Ts>
+		using SystemFunction = std::function<void(SceneInfo, Entity, Ts&...)>;
+
+		//The former type-erased wrapper around it
+		using SystemInvoker = std::function<void(SceneInfo, entt::registry<>&)>;
+
+		template <typename... Ts>
+		SystemInvoker system_invoker(const SystemFunction<Ts...> &f)
+		{
+			return [f](SceneInfo info, entt::registry<> &reg)
+			{
+				reg.view<Ts...>().each(
+					[f, info](auto entity, auto&... params) { f(info, entity, params...); }
+				);
+			};
+		}
+	}
+
+	//Kinematic integration, as a benchmark system
+	auto BenchIntegrate = [](game::SceneInfo info, game::Entity, game::TransformComponent &t, game::KinematicComponent &k)
+	{
+		k.velocity_old = k.velocity;
+		k.velocity += k.acceleration * info.dt;
+		t.position += (k.velocity + k.velocity_old) / 2.0 * info.dt;
+	};
+
+	//Velocity damping, as a benchmark system
+	auto BenchDamp = [](game::SceneInfo info, game::Entity, game::KinematicComponent &k)
+	{
+		k.velocity = k.velocity * (1.0 - 0.1 * info.dt);
+	};
+
+	//What the SYSTEM macro generates for the above, minus registration
+	struct SYS_BenchIntegrate
+	{
+		static void run(game::SceneInfo info, entt::registry<> &reg)
+		{
+			game::systems::each<game::TransformComponent, game::KinematicComponent>(BenchIntegrate, info, reg);
+		}
+	};
+	struct SYS_BenchDamp
+	{
+		static void run(game::SceneInfo info, entt::registry<> &reg)
+		{
+			game::systems::each<game::KinematicComponent>(BenchDamp, info, reg);
+		}
+	};
+
+	//Per-entity cost of invoking systems through each dispatch path
+	void bench_systems()
+	{
+		using namespace game;
+
+		const size_t N_ENTITIES = 10000;
+		const size_t N_TICKS = 1000;
+		const double dt = 1.0 / GAME_RATE;
+
+		Scene scene;
+		entt::registry<> reg;
+		for (size_t i = 0; i < N_ENTITIES; i++)
+		{
+			auto e = reg.create();
+			reg.assign<TransformComponent>(e);
+			reg.assign<KinematicComponent>(e).acceleration = { 0, -9.8, 0 };
+		}
+		SceneInfo info{ scene, dt, reg };
+
+		//Reports the cost of one tick of both systems
+		auto report = [&](const char *path, double t) {
+			std::cout << "  " << path << t / N_TICKS * 1e6 << "us/tick, "
+				<< t / (N_TICKS * N_ENTITIES * 2) * 1e9 << "ns/entity/system" << std::endl;
+		};
+
+		std::cout << "systems: " << N_ENTITIES << " entities, 2 systems, " << N_TICKS << " ticks" << std::endl;
+
+		//Former path: a std::function per system wrapping a std::function per entity
+		std::vector<legacy::SystemInvoker> invokers = {
+			legacy::system_invoker(legacy::SystemFunction<TransformComponent, KinematicComponent>(BenchIntegrate)),
+			legacy::system_invoker(legacy::SystemFunction<KinematicComponent>(BenchDamp)),
+		};
+		report("std::function x2:  ", timed([&] {
+			for (size_t i = 0; i < N_TICKS; i++)
+				for (auto &s : invokers)
+					s(info, reg);
+		}));
+
+		//Current path: a function pointer per system, with the system inlined into its loop
+		std::vector<systems::SystemInvoker> pointers = { &SYS_BenchIntegrate::run, &SYS_BenchDamp::run };
+		report("function pointer:  ", timed([&] {
+			for (size_t i = 0; i < N_TICKS; i++)
+				for (auto s : pointers)
+					s(info, reg);
+		}));
+
+		//Fully static: a compile-time pipeline
+		using BenchPipeline = systems::Pipeline<SYS_BenchIntegrate, SYS_BenchDamp>;
+		report("Pipeline<...>:     ", timed([&] {
+			for (size_t i = 0; i < N_TICKS; i++)
+				BenchPipeline::run(info, reg);
+		}));
+	}
+
+	namespace legacy
+	{
+		//The former spatial grid: an ordered map of hash sets, with neighbours copied into a static set
+		template <typename T>
+		class SpatialGrid
+		{
+		public:
+			using index_type = std::tuple<int, int, int>;
+			using iterator = typename std::unordered_set<T>::iterator;
+
+		private:
+			std::map<index_type, std::unordered_set<T>> grid_;
+			Vector3 cell_size_ = { 40,40,40 };
+
+		public:
+			index_type update(Vector3 v, T elt, index_type previous)
+			{
+				index_type i = index(v);
+				if (i != previous)
+					grid_[previous].erase(elt);
+				grid_[i].emplace(elt);
+				return i;
+			}
+
+			std::pair<iterator, iterator> get_cells_near(Vector3 v)
+			{
+				static std::unordered_set<T> cells;
+				cells.clear();
+
+				for (int i = -1; i < 2; i++)
+					for (int j = -1; j < 2; j++)
+						for (int k = -1; k < 2; k++)
+						{
+							auto [x, y, z] = index(v);
+							auto &cell = grid_[{ x + i, y + j, z + k }];
+							cells.insert(cell.begin(), cell.end());
+						}
+
+				return { cells.begin(), cells.end() };
+			}
+
+			index_type index(Vector3 v) const
+			{
+				int x = static_cast<int>(v.x / cell_size_.x);
+				int y = static_cast<int>(v.y / cell_size_.y);
+				int z = static_cast<int>(v.z / cell_size_.z);
+
+				if (v.x < 0.0) x--;
+				if (v.y < 0.0) y--;
+				if (v.z < 0.0) z--;
+
+				return { x,y,z };
+			}
+		};
+	}
+
+	//Building, updating and querying the spatial grid against the former one
+	void bench_grid()
+	{
+		using namespace game;
+
+		//Colliders drift a little each tick, averaging two per 40-unit cell
+		const size_t N_TICKS = 10;
+		const double STEP = 5.0;
+
+		std::cout << "grid: " << N_TICKS << " ticks of update + neighbour query per collider" << std::endl;
+
+		for (size_t n : { 1000, 10000, 100000 })
+		{
+			double extent = 40.0 * std::cbrt(n / 2.0);
+			std::mt19937 rng(42);
+			std::uniform_real_distribution<> pos(-extent / 2, extent / 2);
+			std::uniform_real_distribution<> step(-STEP, STEP);
+
+			std::vector<Vector3> positions(n);
+			for (auto &p : positions)
+				p = { pos(rng), pos(rng), pos(rng) };
+
+			std::vector<Vector3> moves(n * N_TICKS);
+			for (auto &m : moves)
+				m = { step(rng), step(rng), step(rng) };
+
+			//Runs the ticks over the given grid, returning the neighbours seen (so both can be checked equal)
+			auto simulate = [&](auto &&update, auto &&near) {
+				std::vector<Vector3> p = positions;
+				size_t seen = 0;
+				for (size_t t = 0; t < N_TICKS; t++)
+				{
+					for (size_t i = 0; i < n; i++)
+					{
+						p[i] += moves[t * n + i];
+						update(i, p[i]);
+					}
+					for (size_t i = 0; i < n; i++)
+						seen += near(p[i]);
+				}
+				return seen;
+			};
+
+			size_t seen_old = 0, seen_new = 0;
+
+			double t_old = timed([&] {
+				legacy::SpatialGrid<size_t> grid;
+				std::vector<legacy::SpatialGrid<size_t>::index_type> cells(n);
+				seen_old = simulate(
+					[&](size_t i, Vector3 v) { cells[i] = grid.update(v, i, cells[i]); },
+					[&](Vector3 v) { auto [b, e] = grid.get_cells_near(v); return size_t(std::distance(b, e)); });
+			});
+
+			double t_new = timed([&] {
+				SpatialGrid<size_t> grid;
+				std::vector<SpatialGrid<size_t>::index_type> cells(n, SpatialGrid<size_t>::none);
+				seen_new = simulate(
+					[&](size_t i, Vector3 v) { cells[i] = grid.update(v, i, cells[i]); },
+					[&](Vector3 v) { size_t c = 0; grid.for_each_near(v, [&c](size_t) { c++; }); return c; });
+			});
+
+			std::cout << "  " << n << " colliders: " << t_old / (n * N_TICKS) * 1e9 << "ns former, "
+				<< t_new / (n * N_TICKS) * 1e9 << "ns flat (x" << t_old / t_new << ")"
+				<< (seen_old == seen_new ? "" : ", MISMATCHED NEIGHBOURS") << std::endl;
+		}
+	}
+
+	//Checks that a static collider made kinematic through a command leaves the broadphase's static set,
+	//so it is found where it moves to and no longer where it started
+	void check_static_to_dynamic()
+	{
+		using namespace game;
+
+		const size_t N_TICKS = 60;
+		const double dt = 1.0 / GAME_RATE;
+		const Vector3 START = { 0, 0, 0 }, VELOCITY = { 100, 0, 0 };
+
+		for (auto kind : { Broadphase::Kind::Grid, Broadphase::Kind::SweepAndPrune })
+		{
+			Scene scene(kind);
+			Entity e = scene.create(TransformComponent{ START }, CollisionComponent{ 1, layers::Default, 0 });
+
+			//Found where it was placed, once indexed as static
+			std::vector<Entity> found;
+			auto found_at = [&](Vector3 position) {
+				found.clear();
+				scene.broadphase().query(position, 1, found);
+				return std::find(found.begin(), found.end(), e) != found.end();
+			};
+			scene.tick(dt);
+			bool indexed = found_at(START);
+
+			KinematicComponent k;
+			k.velocity = VELOCITY;
+			scene.commands().assign(e, k);
+			for (size_t tick = 0; tick < N_TICKS; tick++)
+				scene.tick(dt);
+
+			Vector3 position = scene.get<TransformComponent>(e).position;
+			check(indexed && found_at(position) && !found_at(START), std::string(scene.broadphase().name()) +
+				" moves a collider made kinematic by a command out of the static set");
+		}
+	}
+
+	//Finding potential collisions in a generated maze full of moving bullets, with each broadphase
+	void bench_broadphase()
+	{
+		using namespace game;
+
+		const size_t N_TICKS = 100;
+		const double dt = 1.0 / GAME_RATE;
+
+		//As fired by FireBulletResponse
+		const double BULLET_RADIUS = 5.0;
+		const double BULLET_SPEED = 45.0;
+
+		//Bounding sphere of an entity, as the broadphase system sees it
+		struct Body { Entity e; Vector3 position; double radius; bool fixed; };
+
+		prototypes::register_prototypes();
+		Scene maze;
+		procgen::generate_maze(maze, 21, 120, 3, 4, 6);
+
+		const auto &reg = maze.registry();
+		std::vector<Body> colliders;
+		Entity next = 0;
+		reg.view<const TransformComponent, const CollisionComponent>().each([&](auto e, auto &t, auto &c) {
+			double r = c.radius;
+			if (reg.has<DetectionComponent>(e)) r = std::max(r, reg.get<DetectionComponent>(e).c.radius);
+			if (reg.has<HitboxComponent>(e)) r = std::max(r, reg.get<HitboxComponent>(e).c.radius);
+			colliders.push_back({ e, t.position, r, !reg.has<KinematicComponent>(e) });
+			next = std::max(next, Entity(e & entt::entt_traits<Entity>::entity_mask) + 1);
+		});
+
+		//Bullets fly within the bounds of the maze
+		Vector3 lo = { 1e9, 1e9, 1e9 }, hi = { -1e9, -1e9, -1e9 };
+		reg.view<const TransformComponent>().each([&](auto, auto &t) {
+			lo = { std::min(lo.x, t.position.x), std::min(lo.y, t.position.y), std::min(lo.z, t.position.z) };
+			hi = { std::max(hi.x, t.position.x), std::max(hi.y, t.position.y), std::max(hi.z, t.position.z) };
+		});
+
+		//Colliders without kinematics are indexed once, as the static colliders system would
+		std::vector<Broadphase::StaticBody> statics;
+		for (auto &b : colliders)
+			if (b.fixed)
+				statics.push_back({ b.e, b.position, b.radius, ~LayerMask(0), ~LayerMask(0) });
+
+		std::cout << "broadphase: " << colliders.size() << " colliders in a maze (" << statics.size() << " static), "
+			<< N_TICKS << " ticks" << std::endl;
+
+		for (size_t n : { 100, 1000, 5000 })
+		{
+			std::mt19937 rng(42);
+			std::uniform_real_distribution<> x(lo.x, hi.x), z(lo.z, hi.z), angle(0, 6.283185307);
+
+			//Colliders followed by bullets, found by entity through index_of
+			std::vector<Body> start = colliders;
+			std::vector<Vector3> velocities;
+			for (size_t i = 0; i < n; i++)
+			{
+				double a = angle(rng);
+				start.push_back({ Entity(next + i), { x(rng), (lo.y + hi.y) / 2, z(rng) }, BULLET_RADIUS, false });
+				velocities.push_back(Vector3(std::cos(a), 0, std::sin(a)) * BULLET_SPEED);
+			}
+
+			std::vector<size_t> index_of(next + n);
+			for (size_t i = 0; i < start.size(); i++)
+				index_of[start[i].e & entt::entt_traits<Entity>::entity_mask] = i;
+
+			std::cout << "  " << n << " bullets:";
+			for (auto kind : { Broadphase::Kind::Grid, Broadphase::Kind::SweepAndPrune })
+			{
+				auto broadphase = Broadphase::create(kind);
+				std::vector<Body> bodies = start;
+				std::vector<Entity> nearby;
+				size_t candidates = 0, overlaps = 0;
+
+				double t = timed([&] {
+					broadphase->set_static(statics);
+					for (size_t tick = 0; tick < N_TICKS; tick++)
+					{
+						for (size_t i = 0; i < n; i++)
+						{
+							Vector3 &p = bodies[colliders.size() + i].position;
+							p += velocities[i] * dt;
+							if (p.x < lo.x) p.x = hi.x; else if (p.x > hi.x) p.x = lo.x;
+							if (p.z < lo.z) p.z = hi.z; else if (p.z > hi.z) p.z = lo.z;
+						}
+
+						for (auto &b : bodies)
+							if (!b.fixed)
+								broadphase->update(b.e, b.position, b.radius);
+						broadphase->refresh();
+
+						//Bullets look for what they hit, as the collision system would
+						for (size_t i = colliders.size(); i < bodies.size(); i++)
+						{
+							const Body &b = bodies[i];
+							nearby.clear();
+							broadphase->query(b.position, b.radius, nearby);
+							candidates += nearby.size();
+
+							for (auto e : nearby)
+							{
+								const Body &o = bodies[index_of[e & entt::entt_traits<Entity>::entity_mask]];
+								Vector3 d = o.position - b.position;
+								double r = o.radius + b.radius;
+								if (o.e != b.e && d.x * d.x + d.y * d.y + d.z * d.z < r * r)
+									overlaps++;
+							}
+						}
+					}
+				});
+
+				std::cout << " " << broadphase->name() << " " << t / N_TICKS * 1000 << "ms/tick ("
+					<< candidates / N_TICKS << " candidates, " << overlaps / N_TICKS << " overlaps);";
+			}
+			std::cout << std::endl;
+		}
+
+		check_static_to_dynamic();
+	}
+
+	//Half-space of view space, holding the points p with dot(normal, p) <= d
+	struct HalfSpace
+	{
+		glm::dvec3 normal;
+		double d;
+	};
+
+	//Gets the point where the planes of three half-spaces meet, if they meet at one point
+	bool meet(const HalfSpace &a, const HalfSpace &b, const HalfSpace &c, glm::dvec3 &p)
+	{
+		double det = glm::dot(a.normal, glm::cross(b.normal, c.normal));
+		if (std::abs(det) < 1e-12)
+			return false;
+
+		p = (a.d * glm::cross(b.normal, c.normal) + b.d * glm::cross(c.normal, a.normal) + c.d * glm::cross(a.normal, b.normal)) / det;
+		return true;
+	}
+
+	//Gets the distance from a point to the convex region where the given half-spaces overlap, by brute force.
+	//The nearest point of the region is the point itself, or its projection onto the plane of a face, the line
+	//of an edge or a corner, so it is the nearest of those inside the region
+	double distance_to(const std::vector<HalfSpace> &region, glm::dvec3 p)
+	{
+		double nearest = std::numeric_limits<double>::infinity();
+		auto consider = [&](glm::dvec3 q) {
+			for (auto &h : region)
+				if (glm::dot(h.normal, q) > h.d + 1e-9 * (1 + std::abs(h.d) + glm::length(q)))
+					return;
+			nearest = std::min(nearest, glm::length(q - p));
+		};
+
+		consider(p);
+		for (size_t i = 0; i < region.size(); i++)
+		{
+			const HalfSpace &a = region[i];
+			consider(p - a.normal * ((glm::dot(a.normal, p) - a.d) / glm::dot(a.normal, a.normal)));
+
+			for (size_t j = i + 1; j < region.size(); j++)
+			{
+				const HalfSpace &b = region[j];
+				glm::dvec3 q, along = glm::cross(a.normal, b.normal);
+				if (meet(a, b, { along, glm::dot(along, p) }, q))
+					consider(q);
+
+				for (size_t k = j + 1; k < region.size(); k++)
+					if (meet(a, b, region[k], q))
+						consider(q);
+			}
+		}
+
+		return nearest;
+	}
+
+	//Checks binning against brute force for random lights and cameras. Each cluster is the view-space
+	//frustum of its screen tile between the depths where the shader's log-depth formula changes slice.
+	//Every light whose range reaches that frustum must be in the cluster's span, and the spans must lie
+	//one after another, each listing lights that are on once in light order, and together cover indices()
+	void check_clusters()
+	{
+		using namespace game;
+
+		const size_t N_CAMERAS = 64;
+		const size_t N_LIGHTS = 48;
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<> unit(0, 1), spread(-1, 1);
+
+		LightClusters clusters(0.1, RENDER_DISTANCE);
+		const double near_depth = clusters.near_depth(), scale = clusters.slice_scale();
+
+		//The shader's slice of a depth, in its precision
+		size_t mismatched_slices = 0, slices_checked = 0;
+		for (size_t i = 0; i < 100000; i++)
+		{
+			double depth = near_depth * std::exp(unit(rng) * (LightClusters::Z + 2) / scale - 1 / scale);
+
+			//Depths within rounding of a boundary may fall either side of it
+			double u = std::log(std::max(depth, near_depth) / near_depth) * scale;
+			if (std::abs(u - std::round(u)) < 1e-3)
+				continue;
+
+			float near_f = float(near_depth);
+			int shader = std::clamp(int(std::log(std::max(float(depth), near_f) / near_f) * float(scale)), 0, int(LightClusters::Z - 1));
+			mismatched_slices += clusters.slice(depth) != size_t(shader);
+			slices_checked++;
+		}
+		check(mismatched_slices == 0, std::to_string(mismatched_slices) + " of " + std::to_string(slices_checked) +
+			" depths sliced differently to the shader");
+
+		size_t missing = 0, misplaced = 0, reaching = 0, listed = 0;
+		std::vector<PointLightComponent> lights(N_LIGHTS);
+		std::vector<LightClusters::Light> binned(N_LIGHTS);
+		std::vector<HalfSpace> region(6);
+		for (size_t camera = 0; camera < N_CAMERAS; camera++)
+		{
+			//Cameras anywhere, looking anywhere but straight up or down
+			double fov = 30 + 80 * unit(rng), aspect = 0.5 + 2 * unit(rng);
+			double yaw = 2 * glm::pi<double>() * unit(rng), pitch = 1.4 * spread(rng);
+			glm::vec3 eye = glm::vec3(spread(rng), spread(rng), spread(rng)) * 50.0f;
+			glm::vec3 forward = { float(std::cos(yaw) * std::cos(pitch)), float(std::sin(pitch)), float(std::sin(yaw) * std::cos(pitch)) };
+			glm::mat4 view = glm::lookAt(eye, eye + forward, glm::vec3(0, 1, 0));
+
+			//Lights all around them, some off, some reaching everywhere and some straddling the near plane
+			for (auto &l : lights)
+			{
+				glm::vec3 p = eye + glm::vec3(spread(rng), spread(rng), spread(rng)) * 80.0f;
+				l.position = { p.x, p.y, p.z };
+				l.colour = { unit(rng), unit(rng), unit(rng) };
+				l.intensity = 0.2 + 5 * unit(rng);
+				l.constant = unit(rng);
+				l.linear = unit(rng);
+				l.exponent = rng() % 16 == 0 ? 0 : 0.05 + 2 * unit(rng);
+				if (rng() % 16 == 0) l.linear = l.exponent = 0;
+				l.on = rng() % 8 != 0;
+			}
+
+			std::transform(lights.begin(), lights.end(), binned.begin(), cluster_light);
+			clusters.build(view, fov, aspect, binned.data(), binned.size());
+			auto &spans = clusters.clusters();
+			auto &indices = clusters.indices();
+
+			//Spans lie one after another, each listing lights that are on once in light order
+			std::uint32_t offset = 0;
+			for (auto &span : spans)
+			{
+				misplaced += span.offset != offset;
+				for (std::uint32_t k = span.offset; k < span.offset + span.count && k < indices.size(); k++)
+					misplaced += indices[k] >= lights.size() || !lights[indices[k]].on || (k > span.offset && indices[k] <= indices[k - 1]);
+				offset = span.offset + span.count;
+			}
+			misplaced += offset != indices.size();
+
+			//The last slice reaches past every light
+			double tan_y = std::tan(glm::radians(fov) / 2), tan_x = tan_y * aspect;
+			double far_depth = near_depth * std::exp(LightClusters::Z / scale);
+			std::vector<glm::dvec3> centres;
+			std::vector<double> ranges;
+			for (auto &l : lights)
+			{
+				centres.push_back(glm::dvec3(view * glm::vec4(glm::vec3(l.position), 1.0f)));
+				ranges.push_back(light_range(l));
+				if (std::isfinite(ranges.back()))
+					far_depth = std::max(far_depth, -centres.back().z + ranges.back() + 1);
+			}
+
+			for (size_t z = 0; z < LightClusters::Z; z++)
+				for (size_t y = 0; y < LightClusters::Y; y++)
+					for (size_t x = 0; x < LightClusters::X; x++)
+					{
+						//Bounds of the cluster across the screen, and in depth as the shader slices it
+						double x0 = -1 + 2.0 * x / LightClusters::X, x1 = -1 + 2.0 * (x + 1) / LightClusters::X;
+						double y0 = -1 + 2.0 * y / LightClusters::Y, y1 = -1 + 2.0 * (y + 1) / LightClusters::Y;
+						double z0 = near_depth * std::exp(z / scale);
+						double z1 = z + 1 < LightClusters::Z ? near_depth * std::exp((z + 1) / scale) : far_depth;
+
+						//View space looks along -z, so depth is -z and a screen coordinate v is at v * depth * tan
+						region[0] = { { 0, 0, 1 }, -z0 };
+						region[1] = { { 0, 0, -1 }, z1 };
+						region[2] = { { -1, 0, -x0 * tan_x }, 0 };
+						region[3] = { { 1, 0, x1 * tan_x }, 0 };
+						region[4] = { { 0, -1, -y0 * tan_y }, 0 };
+						region[5] = { { 0, 1, y1 * tan_y }, 0 };
+
+						//Box around the cluster's corners, to skip lights far from it
+						glm::dvec3 lo = { std::min(x0 * z0, x0 * z1) * tan_x, std::min(y0 * z0, y0 * z1) * tan_y, -z1 };
+						glm::dvec3 hi = { std::max(x1 * z0, x1 * z1) * tan_x, std::max(y1 * z0, y1 * z1) * tan_y, -z0 };
+
+						const LightClusters::Cluster &span = spans[LightClusters::index(x, y, z)];
+						listed += span.count;
+						for (size_t i = 0; i < lights.size(); i++)
+						{
+							if (!lights[i].on) continue;
+
+							//Allow for the light being transformed to view space in single precision
+							glm::dvec3 c = centres[i];
+							double r = ranges[i], tolerance = 1e-4 * (1 + glm::length(c));
+							if (std::isfinite(r))
+							{
+								glm::dvec3 nearest = { std::clamp(c.x, lo.x, hi.x), std::clamp(c.y, lo.y, hi.y), std::clamp(c.z, lo.z, hi.z) };
+								if (glm::length(nearest - c) >= r - tolerance || distance_to(region, c) >= r - tolerance)
+									continue;
+							}
+
+							reaching++;
+							auto first = indices.begin() + span.offset, last = first + span.count;
+							missing += !std::binary_search(first, last, std::uint32_t(i));
+						}
+					}
+		}
+
+		check(misplaced == 0, std::to_string(misplaced) + " misplaced spans or indices");
+		check(missing == 0, std::to_string(missing) + " of " + std::to_string(reaching) + " lights reaching a cluster missing from it ("
+			+ std::to_string(listed) + " listed)");
+	}
+
+	//Binning a maze's torches into clusters for a camera turning on the spot, as each frame would, then checking
+	//binning against brute force
+	void bench_clusters()
+	{
+		using namespace game;
+
+		const size_t N_FRAMES = 360;
+
+		prototypes::register_prototypes();
+		Scene maze;
+		procgen::generate_maze(maze, 21, 120, 3, 4, 6);
+
+		std::vector<LightClusters::Light> lights;
+		Vector3 centre;
+		maze.registry().view<const PointLightComponent>().each([&](auto, auto &l) {
+			lights.push_back(cluster_light(l));
+			centre += l.position;
+		});
+		if (!lights.empty())
+			centre = centre * (1.0 / lights.size());
+
+		std::cout << "clusters: " << lights.size() << " point lights, " << LightClusters::X << "x" << LightClusters::Y
+			<< "x" << LightClusters::Z << " clusters, " << N_FRAMES << " frames" << std::endl;
+
+		LightClusters clusters(0.1, RENDER_DISTANCE);
+		size_t reached = 0, occupied = 0, most = 0;
+
+		double t = timed([&] {
+			for (size_t frame = 0; frame < N_FRAMES; frame++)
+			{
+				double a = glm::radians(double(frame));
+				glm::vec3 eye = centre;
+				glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(std::cos(a), 0, std::sin(a)), glm::vec3(0, 1, 0));
+				clusters.build(view, CameraComponent().fov, ASPECT_RATIO_VAL, lights.data(), lights.size());
+
+				for (auto &c : clusters.clusters())
+				{
+					reached += c.count;
+					occupied += c.count > 0;
+					most = std::max(most, size_t(c.count));
+				}
+			}
+		});
+
+		std::cout << "  build:         " << t / N_FRAMES * 1000 << "ms/frame" << std::endl;
+		std::cout << "  lights/cluster: " << (occupied ? double(reached) / occupied : 0.0) << " mean of occupied, "
+			<< most << " max, against " << lights.size() << " unclustered" << std::endl;
+
+		check_clusters();
+	}
+
+	//Casting rays and overlapping spheres among a maze's walls and scattered colliders, with each broadphase,
+	//checking every result against a brute-force scan of the colliders and solid planes
+	void bench_queries()
+	{
+		using namespace game;
+
+		const size_t N_COLLIDERS = 2000;
+		const size_t N_QUERIES = 20000;
+		const double dt = 1.0 / GAME_RATE;
+		const LayerMask LAYERS[] = { layers::Default, layers::Player, layers::Enemy, layers::Bullet, layers::Pickup };
+		const LayerMask MASKS[] = { layers::All, layers::Wall, layers::Enemy | layers::Player, layers::Default | layers::Wall, layers::Bullet };
+
+		prototypes::register_prototypes();
+		procgen::MazeWalls walls = procgen::generate_maze_walls(21, 120, 3, 4, 6);
+
+		//Queries fill the maze, from below the floor to above the walls
+		Vector3 lo = { 1e9, -10, 1e9 }, hi = { -1e9, 15, -1e9 };
+		for (auto [x, y] : walls.open)
+		{
+			lo = { std::min(lo.x, x * walls.pitch), lo.y, std::min(lo.z, y * walls.pitch) };
+			hi = { std::max(hi.x, x * walls.pitch), hi.y, std::max(hi.z, y * walls.pitch) };
+		}
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<> unit(0, 1), spread(-1, 1);
+		auto anywhere = [&] { return Vector3(lo.x + (hi.x - lo.x) * unit(rng), lo.y + (hi.y - lo.y) * unit(rng), lo.z + (hi.z - lo.z) * unit(rng)); };
+
+		struct Collider { Vector3 position; double radius; LayerMask layer; bool fixed; };
+		std::vector<Collider> colliders;
+		for (size_t i = 0; i < N_COLLIDERS; i++)
+			colliders.push_back({ anywhere(), 0.5 + 6 * unit(rng), LAYERS[rng() % 5], rng() % 2 == 0 });
+
+		//Rays of every length in every direction, some passing through a collider, and spheres of every size
+		struct Query { Ray ray; Vector3 centre; double radius; LayerMask mask; };
+		std::vector<Query> queries;
+		for (size_t i = 0; i < N_QUERIES; i++)
+		{
+			Vector3 direction = { spread(rng), spread(rng), spread(rng) };
+			direction = direction / std::max(direction.abs(), 1e-9);
+			queries.push_back({ { anywhere(), direction, 200 * unit(rng) }, anywhere(), 30 * unit(rng), MASKS[rng() % 5] });
+		}
+
+		std::cout << "queries: " << walls.merged.size() << " wall planes, " << N_COLLIDERS << " colliders, "
+			<< N_QUERIES << " rays and spheres" << std::endl;
+
+		for (auto kind : { Broadphase::Kind::Grid, Broadphase::Kind::SweepAndPrune })
+		{
+			Scene scene(kind);
+			for (auto &w : walls.merged)
+				scene.instantiate("SolidPlane", w);
+
+			//Colliders touch no layers, so nothing acts on them, and half are static
+			std::vector<Entity> entities;
+			for (auto &c : colliders)
+			{
+				TransformComponent t{ c.position };
+				CollisionComponent collision{ c.radius, c.layer, 0 };
+				entities.push_back(c.fixed ? scene.create(t, collision) : scene.create(t, collision, KinematicComponent()));
+			}
+			for (size_t i = 0; i < N_QUERIES; i++)
+				if (i % 4 == 0)
+					queries[i].ray.ignore = entities[rng() % entities.size()];
+
+			//Index the colliders and planes
+			scene.tick(dt);
+
+			std::vector<Ray> rays;
+			for (auto &q : queries)
+				rays.push_back(q.ray);
+
+			//Cast in batches of the same mask, as raycast_many takes one
+			std::vector<RayHit> hits(N_QUERIES), batch;
+			std::vector<std::vector<Entity>> overlaps(N_QUERIES);
+			double t_rays = timed([&] {
+				for (LayerMask mask : MASKS)
+				{
+					std::vector<Ray> same;
+					std::vector<size_t> which;
+					for (size_t i = 0; i < N_QUERIES; i++)
+						if (queries[i].mask == mask)
+						{
+							same.push_back(rays[i]);
+							which.push_back(i);
+						}
+
+					scene.raycast_many(same, mask, batch);
+					for (size_t j = 0; j < which.size(); j++)
+						hits[which[j]] = batch[j];
+				}
+			});
+			double t_spheres = timed([&] {
+				for (size_t i = 0; i < N_QUERIES; i++)
+					scene.overlap_sphere(queries[i].centre, queries[i].radius, queries[i].mask, overlaps[i]);
+			});
+
+			//Brute force: every collider and solid plane against every query
+			const auto &reg = scene.registry();
+			size_t wrong_rays = 0, wrong_spheres = 0, wrong_single = 0, hit = 0, overlapped = 0;
+			for (size_t i = 0; i < N_QUERIES; i++)
+			{
+				const Query &q = queries[i];
+				const Ray &ray = q.ray;
+
+				//Nearest and next nearest distances along the ray, so ties needn't agree on what was hit
+				double nearest = ray.length, next = std::numeric_limits<double>::infinity();
+				Entity nearest_entity = entt::null;
+				bool any = false;
+				auto consider = [&](double t, Entity e) {
+					if (t < 0 || t > ray.length) return;
+					if (t <= nearest) { next = any ? nearest : next; nearest = t; nearest_entity = e; any = true; }
+					else next = std::min(next, t);
+				};
+
+				std::vector<Entity> expected;
+				reg.view<const TransformComponent, const CollisionComponent>().each([&](auto e, auto &t, auto &c) {
+					if (!(c.layer & q.mask)) return;
+
+					//Nearest point of the ray's line to the centre, then back to where it enters the sphere
+					Vector3 m = t.position - ray.origin;
+					double along = m.x * ray.direction.x + m.y * ray.direction.y + m.z * ray.direction.z;
+					double miss2 = m.x * m.x + m.y * m.y + m.z * m.z - along * along;
+					if (e != ray.ignore && miss2 <= c.radius * c.radius)
+					{
+						if (m.abs() <= c.radius)
+							consider(0, e);
+						else if (along > 0)
+							consider(along - std::sqrt(c.radius * c.radius - miss2), e);
+					}
+
+					Vector3 d = t.position - q.centre;
+					if (d.abs() < q.radius + c.radius)
+						expected.push_back(e);
+				});
+
+				if (q.mask & layers::Wall)
+					reg.view<const SolidPlaneComponent>().each([&](auto, auto &p) {
+						double facing = p.normal.x * ray.direction.x + p.normal.y * ray.direction.y + p.normal.z * ray.direction.z;
+						if (facing == 0) return;
+
+						Vector3 m = p.position - ray.origin;
+						double t = (p.normal.x * m.x + p.normal.y * m.y + p.normal.z * m.z) / facing;
+
+						//Where it crosses the plane must be within the plane's size of its centre line
+						Vector3 point = ray.origin + ray.direction * t, a = p.position - p.span, b = p.position + p.span;
+						Vector3 ab = b - a, ap = point - a;
+						double length2 = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+						double f = length2 > 0 ? std::clamp((ap.x * ab.x + ap.y * ab.y + ap.z * ab.z) / length2, 0.0, 1.0) : 0.5;
+						if ((point - (a + ab * f)).abs() <= p.size)
+							consider(t, entt::null);
+					});
+
+				//Distances may differ by rounding, and ties by which was hit
+				const RayHit &h = hits[i];
+				double tolerance = 1e-6 * (1 + ray.length);
+				bool agrees = h.hit == any && (!any || (std::abs(h.distance - nearest) <= tolerance &&
+					(h.entity == nearest_entity || next - nearest <= tolerance)));
+				wrong_rays += !agrees;
+				hit += any;
+
+				//A single cast matches its batched one
+				RayHit single;
+				scene.raycast(ray, q.mask, single);
+				wrong_single += single.hit != h.hit || single.entity != h.entity || single.distance != h.distance;
+
+				std::sort(expected.begin(), expected.end());
+				std::sort(overlaps[i].begin(), overlaps[i].end());
+				wrong_spheres += expected != overlaps[i];
+				overlapped += !expected.empty();
+			}
+
+			std::cout << "  " << scene.broadphase().name() << ": " << t_rays / N_QUERIES * 1e6 << "us/ray, "
+				<< t_spheres / N_QUERIES * 1e6 << "us/sphere (" << hit << " rays hit, " << overlapped << " spheres overlap)" << std::endl;
+			check(wrong_rays == 0, std::to_string(wrong_rays) + " batched raycasts differ from brute force");
+			check(wrong_single == 0, std::to_string(wrong_single) + " single raycasts differ from batched ones");
+			check(wrong_spheres == 0, std::to_string(wrong_spheres) + " sphere overlaps differ from brute force");
+		}
+	}
+
+	//Checks that bullets fired at a wall stop there, however fast, rather than coming out the other side
+	void check_bullet_walls()
+	{
+		using namespace game;
+
+		//Long enough for the slowest to reach the wall, well before bullets time out
+		const size_t N_TICKS = 120;
+		const double dt = 1.0 / GAME_RATE;
+		const double WALL = 20, RADIUS = 5;
+
+		size_t through = 0, kept = 0, fired = 0;
+		for (double speed : { 45.0, 600.0, 3000.0, 30000.0 })
+			for (double angle : { 0.0, 30.0, -60.0 })
+			{
+				Scene scene;
+				scene.instantiate("SolidPlane", SolidPlaneComponent{ { -1, 0, 0 }, { WALL, 0, 0 }, 40 });
+
+				//As FireBulletResponse fires them, less the model and particles
+				double a = glm::radians(angle);
+				KinematicComponent k;
+				k.velocity = Vector3(std::cos(a), 0, std::sin(a)) * speed;
+				Entity bullet = scene.create(TransformComponent(), k, CollisionComponent{ RADIUS, layers::Bullet, layers::Player | layers::Enemy, true },
+					BulletComponent());
+				fired++;
+
+				for (size_t tick = 0; tick < N_TICKS && scene.valid(bullet); tick++)
+				{
+					scene.tick(dt);
+					through += scene.valid(bullet) && scene.registry().get<TransformComponent>(bullet).position.x > WALL;
+				}
+				kept += scene.valid(bullet);
+			}
+
+		check(through == 0, std::to_string(through) + " ticks with a bullet beyond the wall it was fired at");
+		check(kept == 0, std::to_string(kept) + " of " + std::to_string(fired) + " bullets fired at a wall still flying");
+	}
+
+	//Driving a body at every side of every open cell of a maze through the solid plane system, against
+	//the maze's walls merged into straight runs and placed one round plane per side, as they were before
+	void bench_walls()
+	{
+		using namespace game;
+
+		const size_t N_TICKS = 30;
+		const double dt = 1.0 / GAME_RATE;
+		const double RADIUS = 1.0;
+
+		//Bodies head out of their cell from its centre line and from either side of it, near the corners
+		const double ACROSS[] = { -0.4, 0.0, 0.4 };
+		const int SIDES[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+		prototypes::register_prototypes();
+		procgen::MazeWalls walls = procgen::generate_maze_walls(21, 120, 3, 4, 6);
+		std::set<std::pair<int, int>> open(walls.open.begin(), walls.open.end());
+
+		//A body heading out of an open cell across one side, expected to be blocked if that side faces a solid cell
+		struct Probe { Vector3 start; Vector3 direction; bool walled; };
+		std::vector<Probe> probes;
+		for (auto [x, y] : walls.open)
+			for (auto &side : SIDES)
+				for (double across : ACROSS)
+				{
+					Vector3 direction = { double(side[0]), 0, double(side[1]) };
+					Vector3 start = Vector3(x, 0, y) * walls.pitch + Vector3(side[1], 0, side[0]) * (across * walls.pitch);
+					probes.push_back({ start, direction, !open.count({ x + side[0], y + side[1] }) });
+				}
+
+		//Drives every probe three quarters of a cell through the given walls, returning which were stopped before the side
+		auto drive = [&](const std::vector<SolidPlaneComponent> &planes) {
+			Scene scene;
+			for (auto &p : planes)
+				scene.instantiate("SolidPlane", p);
+
+			//Bodies collide with no layers, so only the walls act on them
+			std::vector<Entity> bodies;
+			for (auto &p : probes)
+			{
+				KinematicComponent k{ true };
+				k.velocity = p.direction * (0.75 * walls.pitch / (N_TICKS * dt));
+				bodies.push_back(scene.create(TransformComponent{ p.start }, k, CollisionComponent{ RADIUS, layers::Default, 0 }));
+			}
+
+			for (size_t tick = 0; tick < N_TICKS; tick++)
+				scene.tick(dt);
+
+			std::vector<bool> blocked;
+			for (size_t i = 0; i < probes.size(); i++)
+			{
+				Vector3 moved = scene.registry().get<TransformComponent>(bodies[i]).position - probes[i].start;
+				blocked.push_back(moved.x * probes[i].direction.x + moved.z * probes[i].direction.z < walls.pitch / 2);
+			}
+			return blocked;
+		};
+
+		std::cout << "walls: " << walls.open.size() << " open cells, " << walls.merged.size() << " merged planes against "
+			<< walls.per_side.size() << " per side, " << probes.size() << " bodies" << std::endl;
+
+		std::vector<bool> merged, per_side;
+		double t_merged = timed([&] { merged = drive(walls.merged); });
+		double t_per_side = timed([&] { per_side = drive(walls.per_side); });
+		std::cout << "  " << N_TICKS << " ticks: " << t_merged * 1000 << "ms merged, " << t_per_side * 1000 << "ms per side" << std::endl;
+
+		//Every body must meet the same fate either way, and be stopped exactly where its cell is walled
+		size_t differ = 0, wrong = 0;
+		for (size_t i = 0; i < probes.size(); i++)
+		{
+			differ += merged[i] != per_side[i];
+			wrong += merged[i] != probes[i].walled;
+		}
+		check(differ == 0, std::to_string(differ) + " bodies blocked differently by merged and per-side walls");
+		check(wrong == 0, std::to_string(wrong) + " bodies blocked where their side isn't walled, or not where it is");
+
+		check_bullet_walls();
+	}
+
+	//All benchmarks by name
+	const std::map<std::string, std::function<void()>> all_benchmarks = {
+		{ "broadphase", bench_broadphase },
+		{ "clusters", bench_clusters },
+		{ "grid", bench_grid },
+		{ "jobs", bench_jobs },
+		{ "queries", bench_queries },
+		{ "systems", bench_systems },
+		{ "walls", bench_walls },
+	};
+}
+
+bool game::benchmarks::run(const std::string &name)
+{
+	if (name == "all")
+	{
+		for (auto &[n, b] : all_benchmarks)
+			b();
+		return !failed;
+	}
+
+	auto it = all_benchmarks.find(name);
+	if (it == all_benchmarks.end())
+	{
+		std::cerr << "Unknown benchmark '" << name << "'. Available:";
+		for (auto &[n, b] : all_benchmarks)
+			std::cerr << " " << n;
+		std::cerr << std::endl;
+		return false;
+	}
+
+	it->second();
+	return !failed;
+}
@@ -0,0 +1,16 @@
+/**
+ * Benchmarks.h
+ * Declares the engine's built-in microbenchmarks, run from
+ * the command line with --bench.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace game::benchmarks
+{
+	//Runs the named benchmark ("all" runs every one), returning false if there is no such benchmark
+	//or a check it makes fails
+	bool run(const std::string &name);
+}
@@ -0,0 +1,21 @@
+/**
+ * Broadphase.cpp
+ * Implements the Broadphase interface, which narrows down the
+ * entities that may be colliding with one another.
+ */
+
+#include "Broadphase.h"
+
+#include "GridBroadphase.h"
+#include "SweepAndPrune.h"
+
+std::unique_ptr<game::Broadphase> game::Broadphase::create(Kind kind)
+{
+	switch (kind)
+	{
+	case Kind::SweepAndPrune:
+		return std::make_unique<SweepAndPrune>();
+	default:
+		return std::make_unique<GridBroadphase>();
+	}
+}
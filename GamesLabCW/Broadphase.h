@@ -0,0 +1,122 @@
+/**
+ * Broadphase.h
+ * Declares the Broadphase interface, which narrows down the
+ * entities that may be colliding with one another.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <entt/entt.hpp>
+
+#include "Vector3.h"
+
+namespace game
+{
+	//Numerical type representing individual entities
+	using Entity = entt::registry<>::entity_type;
+
+	//Unordered pair of entities, stored with the lower identifier first
+	using EntityPair = std::pair<Entity, Entity>;
+
+	//Gets the pair of two entities in storage order
+	inline EntityPair ordered_pair(Entity a, Entity b)
+	{
+		return a < b ? EntityPair{ a, b } : EntityPair{ b, a };
+	}
+
+	//Set of collision layers, one per bit
+	using LayerMask = std::uint32_t;
+
+	//Whether two entities may collide, which they do only if each is on a layer the other's mask accepts
+	inline bool layers_collide(LayerMask layer_a, LayerMask mask_a, LayerMask layer_b, LayerMask mask_b)
+	{
+		return (layer_a & mask_b) && (layer_b & mask_a);
+	}
+
+	class Broadphase
+	{
+	public:
+		//Bounds of an entity which never moves
+		struct StaticBody
+		{
+			Entity entity;
+			Vector3 position;
+			double radius;
+			LayerMask layer;
+			LayerMask mask;
+		};
+
+	private:
+		//Have the static entities changed since they were last set?
+		bool static_stale_ = true;
+
+	protected:
+		//Gets the index of an entity, ignoring its version
+		static size_t slot(Entity e)
+		{
+			return size_t(e & entt::entt_traits<Entity>::entity_mask);
+		}
+
+		//Replaces the static entities with the given ones
+		virtual void build_static(const std::vector<StaticBody> &bodies) = 0;
+
+	public:
+		//Available implementations
+		enum class Kind { Grid, SweepAndPrune };
+
+		//Creates an empty broadphase of the given kind
+		static std::unique_ptr<Broadphase> create(Kind kind);
+
+		virtual ~Broadphase() = default;
+
+		//Inserts or moves an entity, bounded by the given sphere and on the given layers,
+		//colliding with the layers in mask
+		virtual void update(Entity e, Vector3 position, double radius,
+			LayerMask layer = ~LayerMask(0), LayerMask mask = ~LayerMask(0)) = 0;
+
+		//Removes an entity, if present. Static entities stay until next set
+		virtual void remove(Entity e) = 0;
+
+		//Removes all entities, static or not
+		virtual void clear() = 0;
+
+		//Replaces the entities which never move. These are indexed once, apart from the others,
+		//and never paired with one another
+		void set_static(const std::vector<StaticBody> &bodies)
+		{
+			build_static(bodies);
+			static_stale_ = false;
+		}
+
+		//Whether the static entities are still those set last, rather than changed since
+		bool static_valid() const { return !static_stale_; }
+
+		//Marks the static entities as changed, e.g. once one is created or destroyed
+		void invalidate_static() { static_stale_ = true; }
+
+		//Brings the structure up to date after updates, so queries are fast. Queries before then are
+		//still correct, and leave the structure untouched so may run in parallel
+		virtual void refresh() {}
+
+		//Appends each entity on a layer in mask whose bounds overlap the box between the given corners to out, once
+		virtual void query_box(Vector3 lo, Vector3 hi, std::vector<Entity> &out, LayerMask mask = ~LayerMask(0)) const = 0;
+
+		//Appends each entity on a layer in mask whose bounds overlap the given sphere's to out, once
+		void query(Vector3 position, double radius, std::vector<Entity> &out, LayerMask mask = ~LayerMask(0)) const
+		{
+			Vector3 extent = { radius, radius, radius };
+			query_box(position - extent, position + extent, out, mask);
+		}
+
+		//Appends each pair of entities whose bounds overlap and whose layers collide to out,
+		//once and in no particular order
+		virtual void pairs(std::vector<EntityPair> &out) = 0;
+
+		//Gets the name of the implementation, for logging
+		virtual const char *name() const = 0;
+	};
+}
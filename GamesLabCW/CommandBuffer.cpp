@@ -0,0 +1,48 @@
+/**
+ * CommandBuffer.cpp
+ * Implements the CommandBuffer class, which records structural
+ * changes to a scene for applying after all systems have run.
+ */
+
+#include "CommandBuffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+void game::CommandBuffer::apply(std::vector<CommandBuffer> &buffers, Scene &scene)
+{
+	//Gather from every thread's buffer
+	std::vector<Entity> destroys;
+	std::vector<Creation> creates;
+	std::vector<Assignment> assigns;
+	for (auto &b : buffers)
+	{
+		destroys.insert(destroys.end(), b.destroys_.begin(), b.destroys_.end());
+		std::move(b.creates_.begin(), b.creates_.end(), std::back_inserter(creates));
+		std::move(b.assigns_.begin(), b.assigns_.end(), std::back_inserter(assigns));
+
+		b.destroys_.clear();
+		b.creates_.clear();
+		b.assigns_.clear();
+	}
+
+	//Destroy each entity once, even if several systems asked
+	std::sort(destroys.begin(), destroys.end());
+	destroys.erase(std::unique(destroys.begin(), destroys.end()), destroys.end());
+	for (auto e : destroys)
+		if (scene.valid(e))
+			scene.destroy(e);
+
+	//Instantiate, keeping like prototypes (and so pools) together
+	std::stable_sort(creates.begin(), creates.end(),
+		[](const Creation &a, const Creation &b) { return a.prototype < b.prototype; });
+	for (auto &c : creates)
+		c.apply(scene);
+
+	//Assign, one pool at a time, skipping entities destroyed meanwhile
+	std::stable_sort(assigns.begin(), assigns.end(),
+		[](const Assignment &a, const Assignment &b) { return a.type < b.type; });
+	for (auto &a : assigns)
+		if (scene.valid(a.entity))
+			a.apply(scene);
+}
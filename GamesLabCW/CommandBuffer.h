@@ -0,0 +1,69 @@
+/**
+ * CommandBuffer.h
+ * Declares the CommandBuffer class, which records structural
+ * changes to a scene for applying after all systems have run.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+
+namespace game
+{
+	class CommandBuffer
+	{
+	private:
+		//A deferred instantiation of a prototype
+		struct Creation
+		{
+			std::string prototype;
+			std::function<void(Scene&)> apply;
+		};
+
+		//A deferred assignment of a component
+		struct Assignment
+		{
+			entt::registry<>::component_type type;
+			Entity entity;
+			std::function<void(Scene&)> apply;
+		};
+
+		//Entities to destroy
+		std::vector<Entity> destroys_;
+
+		//Entities to instantiate
+		std::vector<Creation> creates_;
+
+		//Components to assign or replace
+		std::vector<Assignment> assigns_;
+
+	public:
+		//Records instantiation of an entity of the given prototype with the given component values
+		template <typename... Ts>
+		void instantiate(std::string p, Ts... components)
+		{
+			creates_.push_back({ p, [p, components...](Scene &scene) { scene.instantiate(p, components...); } });
+		}
+
+		//Records destruction of the given entity
+		void destroy(Entity e) { destroys_.push_back(e); }
+
+		//Records assignment of the given component to the given entity, if it still exists
+		template <typename T>
+		void assign(Entity e, T component)
+		{
+			assigns_.push_back({ entt::registry<>::type<T>(), e, [e, component](Scene &scene) { scene.add<T>(e, component); } });
+		}
+
+		//Is nothing recorded?
+		bool empty() const { return destroys_.empty() && creates_.empty() && assigns_.empty(); }
+
+		//Applies every buffer's commands to the scene in one pass, then clears them.
+		//Destructions come first, then instantiations grouped by prototype, then assignments grouped by pool
+		static void apply(std::vector<CommandBuffer> &buffers, Scene &scene);
+	};
+}
@@ -5,13 +5,13 @@
 
 #pragma once
 
+#include <limits>
 #include <string>
-#include <unordered_set>
+#include <type_traits>
 
 #include "GameEngine.h"
 #include "Vector2.h"
 #include "Vector3.h"
-#include "SpatialGrid.h"
 
 namespace game
 {
@@ -42,7 +42,6 @@ namespace game
 		Vector3 scale{ 1.0, 1.0, 1.0 };
 
 		Vector3 position_old;
-		SpatialGrid<Entity>::index_type last_index;
 	};
 
 	struct CameraComponent
@@ -78,11 +77,6 @@ namespace game
 		Vector3 color_modifier;
 	};
 
-	struct OverlayComponent
-	{
-		std::string texture_file;
-	};
-
 	/* LIGHTING */
 
 	struct AmbientLightComponent
@@ -128,17 +122,37 @@ namespace game
 		Vector3 acceleration_old; //Last tick's acceleration
 	};
 
+	//Collision layers, combined into the layer and mask of a CollisionComponent
+	namespace layers
+	{
+		constexpr LayerMask Default = 1 << 0;
+		constexpr LayerMask Player = 1 << 1;
+		constexpr LayerMask Enemy = 1 << 2;
+		constexpr LayerMask Bullet = 1 << 3;
+		constexpr LayerMask Pickup = 1 << 4;
+		constexpr LayerMask Trigger = 1 << 5;
+		constexpr LayerMask Wall = 1 << 6; //Solid planes, as seen by scene queries
+		constexpr LayerMask All = ~LayerMask(0);
+	}
+
 	struct CollisionComponent
 	{
 		double radius = 3;
-		std::unordered_set<Entity> colliding;
+		LayerMask layer = layers::Default; //Layers this is on
+		LayerMask mask = layers::All; //Layers this collides with
+		bool continuous = false; //Is this swept along its path each tick, so it can't pass through others?
 	};
 
+	//Contacts are kept by the scene, so colliders stay plain data
+	static_assert(std::is_trivially_copyable_v<CollisionComponent>);
+
+	//Static, so indexed once when placed rather than moved
 	struct SolidPlaneComponent
 	{
 		Vector3 normal;
 		Vector3 position;
-		double size = std::numeric_limits<double>::infinity();
+		double size = std::numeric_limits<double>::infinity(); //Reach from the centre line
+		Vector3 span; //From the centre to one end of the centre line, e.g. along a run of walls
 	};
 
 	struct MoveSphere {};
@@ -164,7 +178,6 @@ namespace game
 		bool isHit = false;
 
 
-		float timeSinceLastUpdate = 0;
 		float t = 0;
 		float animationTime = 0;
 
@@ -0,0 +1,94 @@
+/**
+ * ContactTable.cpp
+ * Implements the ContactTable class, which records the pairs
+ * of entities in contact and the frame each was last seen.
+ */
+
+#include "ContactTable.h"
+
+#include <algorithm>
+
+size_t game::ContactTable::probe(key_type key) const
+{
+	size_t mask = slots_.size() - 1;
+	size_t s = hash(key) & mask;
+	while (slots_[s].key != key && slots_[s].key != none)
+		s = (s + 1) & mask;
+	return s;
+}
+
+void game::ContactTable::erase(key_type key)
+{
+	size_t mask = slots_.size() - 1;
+	size_t hole = probe(key);
+	if (slots_[hole].key == none) return;
+
+	slots_[hole] = Slot();
+	size_--;
+
+	//Move later entries of the run back into the hole, unless that would put them before their home slot
+	for (size_t s = (hole + 1) & mask; slots_[s].key != none; s = (s + 1) & mask)
+	{
+		size_t home = hash(slots_[s].key) & mask;
+		if (((s - home) & mask) >= ((s - hole) & mask))
+		{
+			slots_[hole] = slots_[s];
+			slots_[s] = Slot();
+			hole = s;
+		}
+	}
+}
+
+void game::ContactTable::rehash(size_t capacity)
+{
+	std::vector<Slot> old(capacity);
+	std::swap(old, slots_);
+
+	for (auto &slot : old)
+		if (slot.key != none)
+			slots_[probe(slot.key)] = slot;
+}
+
+bool game::ContactTable::touch(EntityPair pair)
+{
+	key_type key = pack(pair);
+	size_t s = probe(key);
+
+	if (slots_[s].key == key)
+	{
+		slots_[s].stamp = stamp_;
+		return true;
+	}
+
+	//Keep the table at most half full
+	if ((size_ + 1) * 2 > slots_.size())
+	{
+		rehash(slots_.size() * 2);
+		s = probe(key);
+	}
+
+	slots_[s] = { key, stamp_ };
+	size_++;
+	return false;
+}
+
+void game::ContactTable::sweep(std::vector<EntityPair> &out)
+{
+	//Collect first, as erasing shifts entries the scan has yet to reach
+	stale_.clear();
+	for (auto &slot : slots_)
+		if (slot.key != none && slot.stamp != stamp_)
+			stale_.push_back(slot.key);
+
+	for (key_type key : stale_)
+	{
+		erase(key);
+		out.push_back(unpack(key));
+	}
+}
+
+void game::ContactTable::clear()
+{
+	std::fill(slots_.begin(), slots_.end(), Slot());
+	size_ = 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * ContactTable.h
+ * Declares the ContactTable class, which records the pairs
+ * of entities in contact and the frame each was last seen.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Broadphase.h"
+
+namespace game
+{
+	class ContactTable
+	{
+	private:
+		//Both entities of a pair packed into one key
+		using key_type = std::uint64_t;
+
+		//Key of no pair, marking empty slots
+		static constexpr key_type none = ~key_type(0);
+
+		//Entry of the open-addressed table, mapping a pair to the frame it was last seen
+		struct Slot
+		{
+			key_type key = none;
+			std::uint32_t stamp = 0;
+		};
+
+		//Power-of-two sized table of pairs, probed linearly
+		std::vector<Slot> slots_ = std::vector<Slot>(64);
+
+		//Number of occupied slots
+		size_t size_ = 0;
+
+		//Current frame
+		std::uint32_t stamp_ = 0;
+
+		//Keys of stale pairs found by the latest sweep, kept to reuse their storage
+		std::vector<key_type> stale_;
+
+		static key_type pack(EntityPair pair)
+		{
+			return (key_type(pair.first) << 32) | key_type(pair.second);
+		}
+
+		static EntityPair unpack(key_type key)
+		{
+			return { Entity(key >> 32), Entity(key & 0xFFFFFFFF) };
+		}
+
+		static size_t hash(key_type key)
+		{
+			return size_t((key * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+
+		//Gets the slot holding the given key, or the empty slot it would occupy
+		size_t probe(key_type key) const;
+
+		//Removes the given key, shifting back any entries probed past it
+		void erase(key_type key);
+
+		void rehash(size_t capacity);
+
+	public:
+		//Starts a new frame, after which pairs are stale until touched again
+		void begin_frame() { stamp_++; }
+
+		//Marks a pair as in contact this frame, returning whether it already was before
+		bool touch(EntityPair pair);
+
+		//Removes every pair not touched this frame, appending each to out
+		void sweep(std::vector<EntityPair> &out);
+
+		//Whether the given pair is in contact
+		bool contains(EntityPair pair) const { return slots_[probe(pack(pair))].key != none; }
+
+		//Gets the number of pairs in contact
+		size_t size() const { return size_; }
+
+		//Invokes f(pair) for every pair in contact, in no particular order
+		template <typename F>
+		void for_each(const F &f) const
+		{
+			for (auto &slot : slots_)
+				if (slot.key != none)
+					f(unpack(slot.key));
+		}
+
+		//Forgets all pairs
+		void clear();
+	};
+}
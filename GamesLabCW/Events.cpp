@@ -82,7 +82,6 @@ namespace game::events
 	void FireBulletResponse(const FireBullet &e)
 	{
 		TransformComponent t; t.position = e.position; t.rotation = e.rotation;
-		CollisionComponent c; c.radius = 5;
 		ModelComponent m; m.model_file = e.bullet_file; m.vertex_shader = e.bullet_vs; m.fragment_shader = e.bullet_fs;
 		
 		KinematicComponent k; k.velocity = Vector2(t.rotation.x, t.rotation.y).direction_hv() * BULLET_SPEED;
@@ -100,7 +99,7 @@ namespace game::events
 		p_fireball.color_variation = Vector3(100, -0.5, 100);
 		p_fireball.color_modifier = Vector3(1, 0.15, 0);
 		BulletComponent b; b.isPlayers = e.isPlayers;
-		e.scene.instantiate("Bullet", m, t, k, p_fireball, b, c);
+		e.scene.instantiate("Bullet", m, t, k, p_fireball, b);
 		
 	}
 	RESPONSE(FireBulletResponse, FireBullet);
@@ -138,7 +137,10 @@ namespace game::events
 
 		auto& bt = e.info.registry.get<TransformComponent>(bullet);
 		auto& at = e.info.registry.get<TransformComponent>(aic);
-		Vector2 cameraPos = Vector2(bt.position.x, bt.position.z);
+
+		//Turn towards where the bullet struck, rather than where it ended the tick
+		Vector3 impact = bt.position_old + (bt.position - bt.position_old) * e.time;
+		Vector2 cameraPos = Vector2(impact.x, impact.z);
 		Vector2 enemyPos = Vector2(at.position.x, at.position.z);
 		Vector2 nonNormal = cameraPos - enemyPos;
 		Vector2 fromPlayerToEnemy = Vector2(glm::normalize(nonNormal.ToGLM()));
@@ -187,13 +189,6 @@ namespace game::events
 		e.info.scene.instantiate("AmbientLight", AmbientLightComponent{ {1, 147.0 / 255.0, 41.0 / 255.0}, 0.1 });
 		e.info.scene.instantiate("DirectionalLight", DirectionalLightComponent{ {0, 0, 0}, 0, {0,0,0} });
 		e.info.scene.instantiate("PointLight", PointLightComponent{ {1, 147.0 / 255.0, 41.0 / 255.0}, 0, {0,5,0} });
-
-		OverlayComponent i_hp; i_hp.texture_file = "models/UI/hearts-2.png";
-		e.info.scene.instantiate("Overlay", i_hp);
-		OverlayComponent i_mp; i_mp.texture_file = "models/UI/mana-3.png";
-		e.info.scene.instantiate("Overlay", i_mp);
-		OverlayComponent i_ch; i_ch.texture_file = "models/UI/crosshair.png";
-		e.info.scene.instantiate("Overlay", i_ch);
 	}
 
 	//HandlePlayerBulletCollision
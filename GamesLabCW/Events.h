@@ -25,6 +25,7 @@ namespace game::events
 		SceneInfo info;
 		Entity a;
 		Entity b;
+		double time = 1; //Fraction of the tick through which they first touched
 	};
 
 	//Represents two entities leaving a collision
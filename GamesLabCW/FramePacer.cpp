@@ -0,0 +1,119 @@
+/**
+ * FramePacer.cpp
+ * Implements the FramePacer class, which holds the main loop
+ * to a target rate by sleeping rather than busy-waiting.
+ */
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace
+{
+	//Smallest remaining wait that is always spun out rather than slept
+	constexpr game::FramePacer::clock::duration SPIN_MIN = std::chrono::microseconds(500);
+
+	//Largest spin window, in case the OS sleeps far longer than asked
+	constexpr game::FramePacer::clock::duration SPIN_MAX = std::chrono::milliseconds(4);
+
+	//Converts a clock duration to seconds
+	double to_seconds(game::FramePacer::clock::duration d)
+	{
+		return std::chrono::duration<double>(d).count();
+	}
+}
+
+game::FramePacer::FramePacer(double rate) : spin_threshold_(SPIN_MIN)
+{
+#ifdef _WIN32
+	//Default scheduler granularity is ~15.6ms, too coarse to sleep a frame away
+	timeBeginPeriod(1);
+#endif
+
+	set_rate(rate);
+	reset();
+}
+
+game::FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void game::FramePacer::set_rate(double rate)
+{
+	period_ = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate));
+}
+
+double game::FramePacer::rate() const
+{
+	return 1.0 / period();
+}
+
+double game::FramePacer::period() const
+{
+	return to_seconds(period_);
+}
+
+void game::FramePacer::reset()
+{
+	next_ = clock::now() + period_;
+}
+
+double game::FramePacer::wait()
+{
+	clock::time_point target = next_;
+
+	//Sleep away most of the wait, leaving a margin for the OS to wake us late
+	clock::time_point now = clock::now();
+	while (target - now > spin_threshold_)
+	{
+		clock::duration request = target - now - spin_threshold_;
+		std::this_thread::sleep_for(request);
+
+		//Keep the margin near twice the oversleep observed (moving average)
+		clock::time_point woke = clock::now();
+		clock::duration oversleep = (woke - now) - request;
+		spin_threshold_ = std::clamp((spin_threshold_ * 7 + oversleep * 2) / 8, SPIN_MIN, SPIN_MAX);
+		now = woke;
+	}
+
+	//Yield for the last fraction of a millisecond, staying responsive to the deadline
+	while (now < target)
+	{
+		std::this_thread::yield();
+		now = clock::now();
+	}
+
+	//Schedule the next frame, dropping missed frames rather than bursting to catch up
+	next_ += period_;
+	if (now > next_)
+		next_ = now + period_;
+
+	//Log the wakeup error
+	last_error_ = to_seconds(now - target);
+	total_error_ += std::abs(last_error_);
+	max_error_ = std::max(max_error_, std::abs(last_error_));
+	frames_++;
+
+	return last_error_;
+}
+
+void game::FramePacer::reset_stats()
+{
+	last_error_ = 0.0;
+	total_error_ = 0.0;
+	max_error_ = 0.0;
+	frames_ = 0;
+}
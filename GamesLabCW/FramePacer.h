@@ -0,0 +1,77 @@
+/**
+ * FramePacer.h
+ * Declares the FramePacer class, which holds the main loop
+ * to a target rate by sleeping rather than busy-waiting.
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace game
+{
+	class FramePacer
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+	private:
+		//Duration of a single frame at the target rate
+		clock::duration period_;
+
+		//Time at which the next frame is due
+		clock::time_point next_;
+
+		//Remaining wait below which we spin instead of sleeping
+		clock::duration spin_threshold_;
+
+		//Wakeup error of the latest frame (seconds, positive if late)
+		double last_error_ = 0.0;
+
+		//Sum of absolute wakeup errors since the last stats reset
+		double total_error_ = 0.0;
+
+		//Largest absolute wakeup error since the last stats reset
+		double max_error_ = 0.0;
+
+		//Number of frames waited for since the last stats reset
+		unsigned long frames_ = 0;
+
+	public:
+		//Constructs a pacer targeting the given rate (Hz)
+		FramePacer(double rate);
+
+		//Releases any OS timer resolution requested by the pacer
+		~FramePacer();
+
+		FramePacer(const FramePacer &) = delete;
+		FramePacer &operator=(const FramePacer &) = delete;
+
+		//Changes the target rate (Hz)
+		void set_rate(double rate);
+
+		//Gets the target rate (Hz)
+		double rate() const;
+
+		//Gets the duration of a single frame (seconds)
+		double period() const;
+
+		//Schedules the next frame one period from now
+		void reset();
+
+		//Blocks until the next frame is due, returning the wakeup error (seconds)
+		double wait();
+
+		//Gets the wakeup error of the latest frame (seconds, positive if late)
+		double last_error() const { return last_error_; }
+
+		//Gets the mean absolute wakeup error since the last stats reset (seconds)
+		double mean_error() const { return frames_ ? total_error_ / frames_ : 0.0; }
+
+		//Gets the largest absolute wakeup error since the last stats reset (seconds)
+		double max_error() const { return max_error_; }
+
+		//Clears the accumulated wakeup statistics
+		void reset_stats();
+	};
+}
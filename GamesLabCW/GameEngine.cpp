@@ -7,8 +7,10 @@
 #include "GameEngine.h"
 
 #include <exception>
+#include <iostream>
 
 #include "Components.h"
+#include "Jobs.h"
 #include "Prototypes.h"
 #include "renderer/Renderer.h"
 #include "Input.h"
@@ -17,8 +19,11 @@
 #include "procedural_generation/procedural_generation.h"
 
 game::GameEngine::GameEngine(bool fullscreen, bool vsync, bool ground) :
-	fullscreen_(fullscreen), vsync_(vsync), ground_(ground)
+	scene_(BROADPHASE), fullscreen_(fullscreen), vsync_(vsync), ground_(ground), pacer_(FRAME_RATE)
 {
+	//Start the job system's worker threads
+	jobs::init();
+
 	//Initialise the GLFW window
 	if (!glfwInit())
 		throw std::exception("GLFW could not be initialised");
@@ -109,6 +114,13 @@ game::GameEngine::GameEngine(bool fullscreen, bool vsync, bool ground) :
 	renderer::load_external_map(paths, "models/Skybox/skybox.obj", TextureType::CUBE, true);
 	renderer::load_external_map(paths, "models/Water/water.obj", TextureType::CUBE, false);
 
+	//Compile the programs of models drawn with their own shaders, so none compile mid-game
+	ProjectileComponent projectile;
+	renderer::load_shader("models/Water/water.obj", "shaders/Water.vert", "shaders/Water.frag");
+	renderer::load_shader("models/Skybox/skybox.obj", "shaders/Skybox.vert", "shaders/Skybox.frag");
+	renderer::load_shader(projectile.model_file, projectile.vs, projectile.fs);
+	renderer::finish_loading();
+
 	//Start game at hub
 	procgen::load_hub(scene_);
 
@@ -118,50 +130,74 @@ game::GameEngine::GameEngine(bool fullscreen, bool vsync, bool ground) :
 
 void game::GameEngine::run()
 {
-	//Time of next update
-	double t_next = glfwGetTime();
+	//Fixed simulation timestep
+	const double dt = 1.0 / GAME_RATE;
+
+	//Simulation time owed but not yet ticked
+	double accumulator = 0;
+
+	//Time of last frame
+	double t_last = glfwGetTime();
 
-	//Time of last update
-	double t_last = 0;
+	//Start pacing from now, rather than from when loading began
+	pacer_.reset();
+	pacer_.reset_stats();
 
 	//Main game loop
 	while (!glfwWindowShouldClose(window_))
 	{
-		//Get the current time
+		//Sleep until the next frame is due
+		pacer_.wait();
+
+		//Accumulate elapsed time, capped so a long stall can't spiral into endless catch-up
 		double t_now = glfwGetTime();
+		double elapsed = t_now - t_last;
+		if (elapsed > 1.0 / GAME_RATE_MIN)
+			elapsed = 1.0 / GAME_RATE_MIN;
+		accumulator += elapsed;
+		t_last = t_now;
+
+		glfwPollEvents();
 
-		//Update if ready
-		if (t_now >= t_next)
+		//Run jobs queued for the main thread, e.g. GL uploads
+		jobs::pump_main();
+
+		//Tick game logic in fixed steps until caught up
+		while (accumulator >= dt)
 		{
-			//Set the next update time based on target rate
-			t_next += 1.0 / GAME_RATE;
+			scene_.tick(dt);
+			accumulator -= dt;
 
-			//Tick game logic
+			//Inputs are consumed by the first tick to see them
 			input::pressed.clear();
 			input::released.clear();
-			glfwPollEvents();
-			double dt = t_now - t_last;
-			if (dt > 1.0 / GAME_RATE_MIN)
-				dt = 1.0 / GAME_RATE_MIN;
-			scene_.tick(dt);
-
-			//Update graphics, but skip if running slowly
-			if (t_now < t_next)
-				draw();
-
-			//Mark this as the latest update
-			t_last = t_now;
+			if (input::cursor_centre)
+				input::cursor_pos = { 0, 0 };
 		}
+
+		//Update graphics, blending between the last two ticks
+		draw(accumulator / dt);
 	}
 
+	//Report how closely the target rate was held
+	std::cout << "Frame pacing: mean wakeup error " << pacer_.mean_error() * 1000.0
+		<< "ms, max " << pacer_.max_error() * 1000.0 << "ms" << std::endl;
+	std::cout << "Shaders: " << renderer::late_shader_compiles() << " programs compiled after loading" << std::endl;
+
 	//Terminate when exiting game loop
+	jobs::shutdown();
 	glfwTerminate();
 }
 
-void game::GameEngine::draw()
+void game::GameEngine::set_rate(double rate)
+{
+	pacer_.set_rate(rate);
+}
+
+void game::GameEngine::draw(double alpha)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	scene_.draw();
+	scene_.draw(alpha);
 	glfwSwapBuffers(window_);
 }
 
@@ -217,11 +253,11 @@ void game::GameEngine::cursor_position_callback(GLFWwindow *window, double x, do
 		//Set cursor to middle
 		glfwSetCursorPos(window, width / 2.0, height / 2.0);
 
-		//Get offset from middle
+		//Accumulate offset from middle until a tick consumes it
 		Vector2 pos_mid;
 		glfwGetCursorPos(window, &pos_mid.x, &pos_mid.y);
 		xy(pos_mid);
-		input::cursor_pos = pos_mid - pos;
+		input::cursor_pos += pos_mid - pos;
 	}
 	else
 		input::cursor_pos = pos;
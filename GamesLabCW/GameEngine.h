@@ -13,6 +13,7 @@
 
 #include "Scene.h"
 #include "Events.h"
+#include "FramePacer.h"
 
 namespace game
 {
@@ -34,15 +35,29 @@ namespace game
 	//Minimum game rate (Hz)
 	constexpr int GAME_RATE_MIN = 10;
 
+	//Target render rate (Hz), independent of the game rate
+	constexpr int FRAME_RATE = 120;
+
 	//Maximium render distance
 	constexpr double RENDER_DISTANCE = 300.0;
 
-	//Cull more distant point lights
+	//Cull point lights whose range ends beyond the render distance of every camera
 	constexpr bool CULL_POINT_LIGHTS = true;
 
+	//Most lights of each kind shading a frame
+	constexpr size_t MAX_AMBIENT_LIGHTS = 4;
+	constexpr size_t MAX_DIRECTIONAL_LIGHTS = 4;
+	constexpr size_t MAX_POINT_LIGHTS = 64;
+
+	//Most point lights shading any one object
+	constexpr size_t MAX_OBJECT_LIGHTS = 8;
+
 	//Allow free-flying movement through solids
 	constexpr bool NOCLIP = false;
 
+	//Broadphase narrowing down potential collisions
+	constexpr Broadphase::Kind BROADPHASE = Broadphase::Kind::SweepAndPrune;
+
 	//Application window title
 	const std::string WINDOW_TITLE = "DunCraw: The Third Realm";
 
@@ -65,8 +80,11 @@ namespace game
 		//Should we draw a default test ground?
 		bool ground_;
 
-		//Renders the game
-		void draw();
+		//Paces the main loop to the target frame rate
+		FramePacer pacer_;
+
+		//Renders the game, interpolating alpha of the way through the latest tick
+		void draw(double alpha);
 
 	public:
 		//Initialise the game context and settings with the given options
@@ -75,6 +93,9 @@ namespace game
 		//Commence the main game loop
 		void run();
 
+		//Sets the target render rate of the main loop (Hz)
+		void set_rate(double rate);
+
 
 		//Handler to quit the game
 		void quit(const events::QuitGame &);
@@ -0,0 +1,135 @@
+/**
+ * GridBroadphase.cpp
+ * Implements the GridBroadphase class, which finds potential
+ * collisions through a uniform spatial grid.
+ */
+
+#include "GridBroadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Do the bounds of two spheres overlap?
+	bool bounds_overlap(game::Vector3 a, double ra, game::Vector3 b, double rb)
+	{
+		double r = ra + rb;
+		return std::abs(a.x - b.x) <= r &&
+			std::abs(a.y - b.y) <= r &&
+			std::abs(a.z - b.z) <= r;
+	}
+
+	//Do a sphere's bounds overlap the box between the given corners?
+	bool bounds_in(game::Vector3 p, double r, game::Vector3 lo, game::Vector3 hi)
+	{
+		return p.x + r >= lo.x && p.x - r <= hi.x &&
+			p.y + r >= lo.y && p.y - r <= hi.y &&
+			p.z + r >= lo.z && p.z - r <= hi.z;
+	}
+}
+
+game::GridBroadphase::GridBroadphase(double cell_size) :
+	grid_({ cell_size, cell_size, cell_size }),
+	static_grid_({ cell_size, cell_size, cell_size })
+{
+}
+
+void game::GridBroadphase::update(Entity e, Vector3 position, double radius, LayerMask layer, LayerMask mask)
+{
+	size_t i = slot(e);
+	if (i >= bodies_.size())
+		bodies_.resize(i + 1);
+
+	//The grid only moves the entity if its cell has changed
+	Body &b = bodies_[i];
+	b.cell = grid_.update(position, e, b.cell);
+	b.entity = e;
+	b.position = position;
+	b.radius = radius;
+	b.layer = layer;
+	b.mask = mask;
+
+	max_radius_ = std::max(max_radius_, radius);
+}
+
+void game::GridBroadphase::remove(Entity e)
+{
+	size_t i = slot(e);
+	if (i >= bodies_.size()) return;
+
+	grid_.erase(bodies_[i].cell, e);
+	bodies_[i].cell = SpatialGrid<Entity>::none;
+}
+
+void game::GridBroadphase::clear()
+{
+	grid_.clear();
+	bodies_.clear();
+	max_radius_ = 0;
+
+	static_grid_.clear();
+	statics_.clear();
+	static_max_radius_ = 0;
+}
+
+void game::GridBroadphase::build_static(const std::vector<StaticBody> &bodies)
+{
+	static_grid_.clear();
+	statics_ = bodies;
+	static_max_radius_ = 0;
+
+	for (size_t i = 0; i < statics_.size(); i++)
+	{
+		static_grid_.insert(statics_[i].position, static_cast<std::uint32_t>(i));
+		static_max_radius_ = std::max(static_max_radius_, statics_[i].radius);
+	}
+}
+
+void game::GridBroadphase::query_box(Vector3 lo, Vector3 hi, std::vector<Entity> &out, LayerMask mask) const
+{
+	//Entities are filed by centre, so look as far out as the largest could reach
+	Vector3 extent = { max_radius_, max_radius_, max_radius_ };
+
+	grid_.for_each_in(lo - extent, hi + extent, [&](Entity e) {
+		const Body &b = bodies_[slot(e)];
+		if ((b.layer & mask) && bounds_in(b.position, b.radius, lo, hi))
+			out.push_back(e);
+	});
+
+	for_each_static_in(lo, hi, [&](const StaticBody &b) {
+		if ((b.layer & mask) && bounds_in(b.position, b.radius, lo, hi))
+			out.push_back(b.entity);
+	});
+}
+
+void game::GridBroadphase::pairs(std::vector<EntityPair> &out)
+{
+	for (size_t i = 0; i < bodies_.size(); i++)
+	{
+		const Body &a = bodies_[i];
+		if (a.cell == SpatialGrid<Entity>::none) continue;
+
+		double reach = a.radius + max_radius_;
+		Vector3 extent = { reach, reach, reach };
+
+		grid_.for_each_in(a.position - extent, a.position + extent, [&](Entity e) {
+			//Each pair is seen from both sides, so keep it from the lower index only
+			size_t j = slot(e);
+			if (j <= i) return;
+
+			const Body &b = bodies_[j];
+			if (layers_collide(a.layer, a.mask, b.layer, b.mask) &&
+				bounds_overlap(a.position, a.radius, b.position, b.radius))
+				out.push_back(ordered_pair(a.entity, b.entity));
+		});
+
+		//Static entities only pair with moving ones, so are seen from this side alone
+		Vector3 own = { a.radius, a.radius, a.radius };
+		for_each_static_in(a.position - own, a.position + own, [&](const StaticBody &b) {
+			if (layers_collide(a.layer, a.mask, b.layer, b.mask) &&
+				bounds_overlap(a.position, a.radius, b.position, b.radius))
+				out.push_back(ordered_pair(a.entity, b.entity));
+		});
+	}
+}
@@ -0,0 +1,68 @@
+/**
+ * GridBroadphase.h
+ * Declares the GridBroadphase class, which finds potential
+ * collisions through a uniform spatial grid.
+ */
+
+#pragma once
+
+#include "Broadphase.h"
+#include "SpatialGrid.h"
+
+namespace game
+{
+	class GridBroadphase : public Broadphase
+	{
+	private:
+		//Bounds of an inserted entity and the cell holding its centre
+		struct Body
+		{
+			Entity entity;
+			Vector3 position;
+			double radius;
+			LayerMask layer;
+			LayerMask mask;
+			SpatialGrid<Entity>::index_type cell = SpatialGrid<Entity>::none;
+		};
+
+		//Moving entities by the cell holding their centre
+		SpatialGrid<Entity> grid_;
+
+		//Each moving entity, by entity index
+		std::vector<Body> bodies_;
+
+		//Largest radius of a moving entity inserted since the last clear, widening every query
+		double max_radius_ = 0;
+
+		//Static entities by the cell holding their centre, as positions in statics_
+		SpatialGrid<std::uint32_t> static_grid_;
+
+		//Each static entity, in the order set
+		std::vector<StaticBody> statics_;
+
+		//Largest radius of a static entity
+		double static_max_radius_ = 0;
+
+		//Invokes f(body) for every static body whose bounds may reach the box between the given corners
+		template <typename F>
+		void for_each_static_in(Vector3 lo, Vector3 hi, const F &f) const
+		{
+			Vector3 extent = { static_max_radius_, static_max_radius_, static_max_radius_ };
+			static_grid_.for_each_in(lo - extent, hi + extent, [&](std::uint32_t i) { f(statics_[i]); });
+		}
+
+	protected:
+		void build_static(const std::vector<StaticBody> &bodies) override;
+
+	public:
+		//Creates an empty broadphase with cells of the given size
+		explicit GridBroadphase(double cell_size = 40.0);
+
+		void update(Entity e, Vector3 position, double radius, LayerMask layer, LayerMask mask) override;
+		void remove(Entity e) override;
+		void clear() override;
+		void query_box(Vector3 lo, Vector3 hi, std::vector<Entity> &out, LayerMask mask) const override;
+		void pairs(std::vector<EntityPair> &out) override;
+		const char *name() const override { return "grid"; }
+	};
+}
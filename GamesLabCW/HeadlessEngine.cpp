@@ -0,0 +1,68 @@
+/**
+ * HeadlessEngine.cpp
+ * Implements the HeadlessEngine class, which runs the game
+ * simulation without a window or graphics context.
+ */
+
+#include "HeadlessEngine.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "Components.h"
+#include "Jobs.h"
+#include "GameEngine.h"
+#include "Prototypes.h"
+#include "Scheduler.h"
+
+#include "procedural_generation/procedural_generation.h"
+
+game::HeadlessEngine::HeadlessEngine(bool maze, Broadphase::Kind broadphase) :
+	scene_(broadphase)
+{
+	//Start the job system's worker threads
+	jobs::init();
+
+	//Set event handlers
+	for (auto &r : events::responses)
+		r->log();
+
+	//Load entity prototypes
+	prototypes::register_prototypes();
+
+	//No models are loaded, so render-side updates from systems are no-ops
+	if (maze)
+		procgen::generate_maze(scene_, 21, 120, 3, 4, 6);
+	else
+		procgen::load_hub(scene_);
+
+	scene_.scheduler().log(std::cout);
+	std::cout << "Broadphase: " << scene_.broadphase().name() << std::endl;
+}
+
+double game::HeadlessEngine::run(unsigned long ticks)
+{
+	using clock = std::chrono::steady_clock;
+
+	//Fixed simulation timestep
+	const double dt = 1.0 / GAME_RATE;
+
+	//Tick as fast as possible
+	auto start = clock::now();
+	for (unsigned long i = 0; i < ticks; i++)
+		scene_.tick(dt);
+	double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+	//Report throughput, which can't be measured over no ticks or too short a run for the clock
+	std::cout << "Headless: " << ticks << " ticks in " << elapsed << "s";
+	if (ticks == 0 || elapsed <= 0)
+	{
+		std::cout << " (too short to measure)" << std::endl;
+		return 0;
+	}
+
+	double tps = ticks / elapsed;
+	std::cout << " (" << tps << " ticks/s, " << elapsed * 1000.0 / ticks << "ms/tick)" << std::endl;
+
+	return tps;
+}
@@ -0,0 +1,30 @@
+/**
+ * HeadlessEngine.h
+ * Declares the HeadlessEngine class, which runs the game
+ * simulation without a window or graphics context.
+ */
+
+#pragma once
+
+#include "Scene.h"
+
+namespace game
+{
+	class HeadlessEngine
+	{
+	private:
+		//The current Scene containing all entities
+		Scene scene_;
+
+	public:
+		//Initialise the simulation, starting at the hub or in a procedurally generated maze
+		HeadlessEngine(bool maze, Broadphase::Kind broadphase);
+
+		//Runs the given number of fixed-timestep ticks, returning the ticks per second achieved,
+		//or zero if the run was too short to measure
+		double run(unsigned long ticks);
+
+		//Gets the simulated scene
+		Scene &scene() { return scene_; }
+	};
+}
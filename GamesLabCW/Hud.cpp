@@ -0,0 +1,76 @@
+/**
+ * Hud.cpp
+ * Implements the Hud class, the retained heads-up display
+ * drawn over the scene.
+ */
+
+#include "Hud.h"
+
+#include <algorithm>
+
+#include "Components.h"
+#include "renderer/Renderer.h"
+
+namespace
+{
+	//Health below which the game is lost
+	const int MIN_HEALTH = 1;
+
+	//Number of heart and mana icons
+	const int MAX_HEALTH = 3;
+	const int MAX_MANA = 3;
+
+	//Time to show the start screen for (seconds)
+	const double START_OVERLAY_MAX = 7.0;
+}
+
+void game::Hud::update(entt::registry<> &reg, double dt)
+{
+	auto players = reg.view<FirstPersonControllerComponent, StatsComponent>();
+
+	set(visible_, players.begin() != players.end());
+	if (!visible_) return;
+
+	auto &s = players.get<StatsComponent>(*players.begin());
+
+	set(lost_, s.health < MIN_HEALTH);
+	set(won_, !lost_ && s.gameComplete);
+	if (lost_ || won_) return;
+
+	//The start screen counts down only while playing
+	start_timer_ += dt;
+	set(start_, start_timer_ < START_OVERLAY_MAX);
+
+	set(health_, std::clamp(s.health, MIN_HEALTH, MAX_HEALTH));
+	set(mana_, std::clamp(int(s.mana), 0, MAX_MANA));
+}
+
+std::vector<std::string> game::Hud::files() const
+{
+	if (!visible_) return {};
+	if (lost_) return { "models/UI/lose.png" };
+	if (won_) return { "models/UI/win.png" };
+
+	std::vector<std::string> f;
+	if (start_)
+		f.push_back("models/UI/start.png");
+	f.push_back("models/UI/hearts-" + std::to_string(health_) + ".png");
+	f.push_back("models/UI/mana-" + std::to_string(mana_) + ".png");
+	f.push_back("models/UI/crosshair.png");
+	return f;
+}
+
+void game::Hud::draw()
+{
+	//Only look overlays up when what's shown has changed
+	if (dirty_)
+	{
+		layers_.clear();
+		for (auto &file : files())
+			if (auto overlay = renderer::get_overlay(file))
+				layers_.push_back(overlay);
+		dirty_ = false;
+	}
+
+	renderer::render_overlays(layers_);
+}
@@ -0,0 +1,63 @@
+/**
+ * Hud.h
+ * Declares the Hud class, the retained heads-up display
+ * drawn over the scene.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <entt/entt.hpp>
+
+namespace game
+{
+	class Overlay;
+
+	class Hud
+	{
+	private:
+		//Player state currently shown
+		int health_ = -1;
+		int mana_ = -1;
+		bool won_ = false;
+		bool lost_ = false;
+		bool start_ = false;
+
+		//Is there a player to show the state of?
+		bool visible_ = false;
+
+		//Time the start screen has been shown for
+		double start_timer_ = 0.0;
+
+		//Must the layers be looked up again?
+		bool dirty_ = true;
+
+		//Overlays currently shown, back to front
+		std::vector<Overlay*> layers_;
+
+		//Gets the texture files of the overlays to show, back to front
+		std::vector<std::string> files() const;
+
+		//Changes a shown value, marking the layers dirty if it differs
+		template <typename T>
+		void set(T &shown, T value)
+		{
+			if (shown != value)
+			{
+				shown = value;
+				dirty_ = true;
+			}
+		}
+
+	public:
+		//Updates the shown state from the player's stats
+		void update(entt::registry<> &reg, double dt);
+
+		//Draws every layer in a single pass
+		void draw();
+
+		//Forces the layers to be looked up again on the next draw
+		void invalidate() { dirty_ = true; }
+	};
+}
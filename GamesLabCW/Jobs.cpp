@@ -0,0 +1,306 @@
+/**
+ * Jobs.cpp
+ * Implements the engine's work-stealing job system, running
+ * small tasks across all hardware threads.
+ */
+
+#include "Jobs.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace game::jobs
+{
+	//A queued job and the group it belongs to
+	struct Task
+	{
+		Job job;
+		Counter *counter;
+	};
+
+	//Jobs queued by one thread; the owner works from the back, thieves from the front
+	struct Deque
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	//Grants the implementation access to counters
+	struct Runner
+	{
+		static void add(Counter *c)
+		{
+			if (c) c->pending_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static void finish(Counter *c)
+		{
+			if (c) c->pending_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	};
+}
+
+namespace
+{
+	using game::jobs::Counter;
+	using game::jobs::Deque;
+	using game::jobs::Runner;
+	using game::jobs::Task;
+
+	//Per-thread deques, the first belonging to the main thread
+	std::vector<std::unique_ptr<Deque>> deques;
+
+	//Worker threads
+	std::vector<std::thread> workers;
+
+	//Jobs which may only run on the main thread
+	Deque main_tasks;
+
+	//Number of jobs sitting in any deque (excluding main-thread jobs)
+	std::atomic<size_t> queued{ 0 };
+
+	//Number of workers asleep waiting for jobs
+	std::atomic<size_t> sleeping{ 0 };
+
+	//Are the workers shutting down?
+	std::atomic<bool> stopping{ false };
+
+	//Wakes sleeping workers
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+
+	//First exception thrown by a job, rethrown by the next wait
+	std::mutex error_mutex;
+	std::exception_ptr error;
+
+	//Identity of the main thread
+	std::thread::id main_id;
+
+	//Index of this thread's deque
+	thread_local size_t tl_index = 0;
+
+	//Group of the job currently running on this thread, adopted by the jobs it spawns
+	thread_local Counter *tl_current = nullptr;
+
+	//Runs a task on this thread, completing it in its group
+	void execute(Task &t)
+	{
+		Counter *parent = tl_current;
+		tl_current = t.counter;
+		try
+		{
+			t.job();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error)
+				error = std::current_exception();
+		}
+		tl_current = parent;
+
+		Runner::finish(t.counter);
+	}
+
+	//Takes the newest job from the given deque
+	bool pop(Deque &d, Task &out)
+	{
+		std::lock_guard<std::mutex> lock(d.mutex);
+		if (d.tasks.empty()) return false;
+		out = std::move(d.tasks.back());
+		d.tasks.pop_back();
+		return true;
+	}
+
+	//Takes the oldest job from the given deque
+	bool steal(Deque &d, Task &out)
+	{
+		std::lock_guard<std::mutex> lock(d.mutex);
+		if (d.tasks.empty()) return false;
+		out = std::move(d.tasks.front());
+		d.tasks.pop_front();
+		return true;
+	}
+
+	//Runs one job from this thread's deque, else stolen from another, returning whether there was one
+	bool run_one()
+	{
+		size_t n = deques.size();
+		if (n == 0 || queued.load() == 0) return false;
+
+		Task t;
+		bool found = pop(*deques[tl_index], t);
+		for (size_t k = 1; !found && k < n; k++)
+			found = steal(*deques[(tl_index + k) % n], t);
+
+		if (!found) return false;
+
+		queued.fetch_sub(1);
+		execute(t);
+		return true;
+	}
+
+	//Main loop of each worker
+	void work(size_t index)
+	{
+		tl_index = index;
+
+		while (true)
+		{
+			if (run_one()) continue;
+
+			//Sleep until there is work to steal
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleeping.fetch_add(1);
+			sleep_cv.wait(lock, [] { return stopping.load() || queued.load() > 0; });
+			sleeping.fetch_sub(1);
+
+			if (stopping.load() && queued.load() == 0)
+				return;
+		}
+	}
+
+	//Rethrows the first exception raised by a job, if any
+	void rethrow()
+	{
+		std::lock_guard<std::mutex> lock(error_mutex);
+		if (error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+	}
+
+	//Stops the workers at program exit, if not already done
+	struct Guard { ~Guard() { game::jobs::shutdown(); } } guard;
+}
+
+void game::jobs::init(size_t n)
+{
+	if (!deques.empty()) return;
+
+	main_id = std::this_thread::get_id();
+	tl_index = 0;
+
+	for (size_t i = 0; i <= n; i++)
+		deques.push_back(std::make_unique<Deque>());
+
+	for (size_t i = 1; i <= n; i++)
+		workers.emplace_back(work, i);
+}
+
+void game::jobs::init()
+{
+	init(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+}
+
+void game::jobs::shutdown()
+{
+	if (deques.empty()) return;
+
+	//Workers drain the deques before exiting
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	sleep_cv.notify_all();
+
+	for (auto &w : workers)
+		w.join();
+
+	workers.clear();
+	deques.clear();
+	stopping = false;
+
+	if (is_main_thread())
+		pump_main();
+}
+
+size_t game::jobs::worker_count()
+{
+	return workers.size();
+}
+
+bool game::jobs::is_main_thread()
+{
+	return deques.empty() || std::this_thread::get_id() == main_id;
+}
+
+size_t game::jobs::thread_index()
+{
+	return tl_index;
+}
+
+void game::jobs::run(Job job, Counter *counter)
+{
+	if (!counter)
+		counter = tl_current;
+	Runner::add(counter);
+
+	//Without workers, nothing would ever steal it
+	if (workers.empty())
+	{
+		Task t{ std::move(job), counter };
+		execute(t);
+		rethrow();
+		return;
+	}
+
+	//Counted before it becomes visible, so thieves never see it uncounted
+	queued.fetch_add(1);
+	{
+		Deque &d = *deques[tl_index];
+		std::lock_guard<std::mutex> lock(d.mutex);
+		d.tasks.push_back({ std::move(job), counter });
+	}
+
+	if (sleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		sleep_cv.notify_one();
+	}
+}
+
+void game::jobs::run_main(Job job, Counter *counter)
+{
+	Runner::add(counter);
+
+	std::lock_guard<std::mutex> lock(main_tasks.mutex);
+	main_tasks.tasks.push_back({ std::move(job), counter });
+}
+
+void game::jobs::pump_main()
+{
+	Task t;
+	while (steal(main_tasks, t))
+		execute(t);
+
+	rethrow();
+}
+
+void game::jobs::wait(Counter &counter)
+{
+	bool main = is_main_thread();
+
+	while (!counter.done())
+	{
+		if (run_one()) continue;
+
+		if (main)
+		{
+			Task t;
+			if (steal(main_tasks, t))
+			{
+				execute(t);
+				continue;
+			}
+		}
+
+		std::this_thread::yield();
+	}
+
+	rethrow();
+}
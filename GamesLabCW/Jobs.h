@@ -0,0 +1,108 @@
+/**
+ * Jobs.h
+ * Declares the engine's work-stealing job system, running
+ * small tasks across all hardware threads.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <entt/entt.hpp>
+
+namespace game::jobs
+{
+	//Unit of work to be run by the job system
+	using Job = std::function<void()>;
+
+	//Tracks completion of a group of jobs, including any jobs they spawn
+	class Counter
+	{
+	private:
+		//Number of jobs in the group not yet finished
+		std::atomic<size_t> pending_{ 0 };
+
+		friend struct Runner;
+
+	public:
+		//Have all jobs in the group finished?
+		bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+	};
+
+	//Starts the given number of worker threads alongside the calling (main) thread
+	void init(size_t workers);
+
+	//Starts a worker thread for every hardware thread but the main one
+	void init();
+
+	//Finishes outstanding jobs and joins all workers
+	void shutdown();
+
+	//Gets the number of worker threads (zero if not started)
+	size_t worker_count();
+
+	//Is the calling thread the main thread?
+	bool is_main_thread();
+
+	//Gets the calling thread's index: zero for the main thread, then one per worker
+	size_t thread_index();
+
+	//Queues a job for any thread. Without a counter, jobs spawned from within a job join its parent's group
+	void run(Job job, Counter *counter = nullptr);
+
+	//Queues a job to be run only by the main thread, e.g. for GL calls
+	void run_main(Job job, Counter *counter = nullptr);
+
+	//Runs all queued main-thread jobs (main thread only)
+	void pump_main();
+
+	//Blocks until the counter's jobs have finished, running other jobs meanwhile
+	void wait(Counter &counter);
+
+	//Invokes f(i) for every i in [begin, end), split into chunks of at most grain
+	template <typename F>
+	void parallel_for(size_t begin, size_t end, size_t grain, const F &f)
+	{
+		grain = std::max<size_t>(grain, 1);
+
+		//Not worth splitting
+		if (worker_count() == 0 || end - begin <= grain)
+		{
+			for (size_t i = begin; i < end; i++)
+				f(i);
+			return;
+		}
+
+		Counter counter;
+		for (size_t lo = begin; lo < end; lo += grain)
+		{
+			size_t hi = std::min(lo + grain, end);
+			run([&f, lo, hi] {
+				for (size_t i = lo; i < hi; i++)
+					f(i);
+			}, &counter);
+		}
+		wait(counter);
+	}
+
+	//Invokes f(entity, components...) for every entity with the given components, in parallel chunks
+	template <typename... Cs, typename F>
+	void parallel_for_each(entt::registry<> &reg, size_t grain, const F &f)
+	{
+		//Creates any missing pools, so must happen before spawning
+		reg.view<Cs...>();
+
+		//Walk the smallest pool, skipping entities lacking the others
+		size_t n = std::numeric_limits<size_t>::max();
+		const entt::registry<>::entity_type *data = nullptr;
+		((reg.size<Cs>() < n ? (n = reg.size<Cs>(), data = reg.data<Cs>(), 0) : 0), ...);
+
+		parallel_for(0, n, grain, [&](size_t i) {
+			auto e = data[i];
+			if (reg.has<Cs...>(e))
+				f(e, reg.get<Cs>(e)...);
+		});
+	}
+}
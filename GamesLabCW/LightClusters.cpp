@@ -0,0 +1,102 @@
+/**
+ * LightClusters.cpp
+ * Implements the LightClusters class, which bins point lights
+ * into a grid of view-space cells for clustered shading.
+ */
+
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+	//Gets the tile of a normalised device coordinate, clamped to the grid
+	size_t tile(double ndc, size_t tiles)
+	{
+		double t = std::floor((ndc + 1.0) / 2.0 * tiles);
+		return size_t(std::clamp(t, 0.0, double(tiles - 1)));
+	}
+}
+
+game::LightClusters::LightClusters(double near_depth, double far_depth) :
+	near_(near_depth), slice_scale_(Z / std::log(far_depth / near_depth))
+{
+}
+
+size_t game::LightClusters::slice(double depth) const
+{
+	if (depth <= near_) return 0;
+	return std::min(size_t(std::log(depth / near_) * slice_scale_), Z - 1);
+}
+
+void game::LightClusters::build(const glm::mat4 &view, double fov, double aspect, const Light *lights, size_t n)
+{
+	double tan_y = std::tan(fov * glm::pi<double>() / 360.0);
+	double tan_x = tan_y * aspect;
+
+	//Find the clusters each light reaches, counting the lights of each cluster
+	std::fill(clusters_.begin(), clusters_.end(), Cluster{ 0, 0 });
+	ranges_.assign(n, { 1, 0, 1, 0, 1, 0 });
+
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!lights[i].on) continue;
+
+		glm::vec4 c = view * glm::vec4(lights[i].position, 1.0f);
+		double r = lights[i].range;
+		double depth = -c.z;
+
+		//Lights wholly behind the camera reach nothing
+		if (depth + r < near_) continue;
+
+		Range &g = ranges_[i];
+		if (!std::isfinite(r))
+			g = { 0, X - 1, 0, Y - 1, 0, Z - 1 };
+		else
+		{
+			double z0 = std::max(depth - r, near_), z1 = depth + r;
+
+			//Bounds across the screen of the light's view-space box between those depths
+			auto lo = [&](double v, double t) { return v / ((v < 0 ? z0 : z1) * t); };
+			auto hi = [&](double v, double t) { return v / ((v > 0 ? z0 : z1) * t); };
+			double x0 = lo(c.x - r, tan_x), x1 = hi(c.x + r, tan_x);
+			double y0 = lo(c.y - r, tan_y), y1 = hi(c.y + r, tan_y);
+
+			//Off screen
+			if (x1 < -1 || x0 > 1 || y1 < -1 || y0 > 1) continue;
+
+			g = { tile(x0, X), tile(x1, X), tile(y0, Y), tile(y1, Y), slice(z0), slice(z1) };
+		}
+
+		for (size_t z = g.z0; z <= g.z1; z++)
+			for (size_t y = g.y0; y <= g.y1; y++)
+				for (size_t x = g.x0; x <= g.x1; x++)
+					clusters_[index(x, y, z)].count++;
+	}
+
+	//Lay the clusters' spans out one after another
+	std::uint32_t offset = 0;
+	for (auto &cluster : clusters_)
+	{
+		cluster.offset = offset;
+		offset += cluster.count;
+		cluster.count = 0;
+	}
+	indices_.resize(offset);
+
+	//Fill each span in light order
+	for (size_t i = 0; i < n; i++)
+	{
+		const Range &g = ranges_[i];
+		for (size_t z = g.z0; z <= g.z1; z++)
+			for (size_t y = g.y0; y <= g.y1; y++)
+				for (size_t x = g.x0; x <= g.x1; x++)
+				{
+					Cluster &cluster = clusters_[index(x, y, z)];
+					indices_[cluster.offset + cluster.count++] = static_cast<std::uint32_t>(i);
+				}
+	}
+}
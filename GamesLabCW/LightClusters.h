@@ -0,0 +1,85 @@
+/**
+ * LightClusters.h
+ * Declares the LightClusters class, which bins point lights
+ * into a grid of view-space cells for clustered shading.
+ * Lights are given as plain positions and ranges, so it
+ * depends on nothing of the engine but glm.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace game
+{
+	class LightClusters
+	{
+	public:
+		//Screen tiles across and down, and depth slices, of the grid
+		static constexpr size_t X = 16;
+		static constexpr size_t Y = 9;
+		static constexpr size_t Z = 24;
+
+		//Point light to bin, reaching as far as its range, which may be infinite
+		struct Light
+		{
+			glm::vec3 position;
+			double range;
+			bool on = true;
+		};
+
+		//Lights reaching a cluster, as a span of indices()
+		struct Cluster
+		{
+			std::uint32_t offset;
+			std::uint32_t count;
+		};
+
+	private:
+		//Depth of the near edge of the first slice
+		double near_;
+
+		//Slices per unit of log depth, as slices grow exponentially with depth
+		double slice_scale_;
+
+		//Every cluster, by index()
+		std::vector<Cluster> clusters_ = std::vector<Cluster>(X * Y * Z);
+
+		//Indices of the lights reaching each cluster, one span per cluster
+		std::vector<std::uint32_t> indices_;
+
+		//Clusters reached by each light, as inclusive ranges, kept between builds
+		struct Range { size_t x0, x1, y0, y1, z0, z1; };
+		std::vector<Range> ranges_;
+
+	public:
+		//Creates empty clusters covering the given range of view depths. Depths beyond it
+		//fall in the nearest or furthest slice
+		LightClusters(double near_depth, double far_depth);
+
+		//Bins lights into the clusters of a camera with the given view matrix, vertical field
+		//of view (degrees) and aspect ratio. Indices refer to positions in the given array
+		void build(const glm::mat4 &view, double fov, double aspect, const Light *lights, size_t n);
+
+		//Gets every cluster, by index()
+		const std::vector<Cluster> &clusters() const { return clusters_; }
+
+		//Gets the light indices the clusters refer to
+		const std::vector<std::uint32_t> &indices() const { return indices_; }
+
+		//Gets the index of the cluster at the given tile and slice
+		static size_t index(size_t x, size_t y, size_t z) { return (z * Y + y) * X + x; }
+
+		//Gets the slice holding the given view depth
+		size_t slice(double depth) const;
+
+		//Gets the nearest depth of the first slice
+		double near_depth() const { return near_; }
+
+		//Gets the slices per unit of log depth
+		double slice_scale() const { return slice_scale_; }
+	};
+}
@@ -0,0 +1,107 @@
+/**
+ * LightSelection.cpp
+ * Implements the functions choosing which point lights shade
+ * each object, by their influence over its bounds.
+ */
+
+#include "LightSelection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+double game::light_influence(const PointLightComponent &light, double distance)
+{
+	double peak = light.intensity * std::max({ light.colour.x, light.colour.y, light.colour.z });
+	double falloff = light.constant + light.linear * distance + light.exponent * distance * distance;
+	return falloff > 0 ? peak / falloff : std::numeric_limits<double>::infinity();
+}
+
+double game::light_range(const PointLightComponent &light)
+{
+	//Solve intensity / (constant + linear d + exponent d^2) = LIGHT_CUTOFF for d
+	double peak = light.intensity * std::max({ light.colour.x, light.colour.y, light.colour.z });
+	double k = peak / LIGHT_CUTOFF - light.constant;
+	if (k <= 0)
+		return 0;
+
+	if (light.exponent > 0)
+		return (-light.linear + std::sqrt(light.linear * light.linear + 4 * light.exponent * k)) / (2 * light.exponent);
+	if (light.linear > 0)
+		return k / light.linear;
+	return std::numeric_limits<double>::infinity();
+}
+
+game::LightClusters::Light game::cluster_light(const PointLightComponent &light)
+{
+	return { glm::vec3(light.position), light_range(light), light.on };
+}
+
+game::LightSet game::select_lights(Vector3 centre, double radius, const PointLightComponent *lights, size_t n, size_t k)
+{
+	//Brightest lights so far, brightest first
+	struct Candidate { double influence; size_t index; };
+	Candidate best[LIGHT_SET_CAPACITY];
+	size_t found = 0;
+
+	n = std::min(n, LIGHT_SET_CAPACITY);
+	k = std::min(k, LIGHT_SET_CAPACITY);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!lights[i].on) continue;
+
+		//Lights are brightest at the nearest point of the sphere
+		Vector3 d = lights[i].position - centre;
+		double distance = std::max(std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z) - radius, 0.0);
+		double influence = light_influence(lights[i], distance);
+		if (influence < LIGHT_CUTOFF) continue;
+
+		//Insert in order, dropping the dimmest once full
+		size_t j = std::min(found, k);
+		if (j == k && (k == 0 || influence <= best[k - 1].influence)) continue;
+		for (; j > 0 && best[j - 1].influence < influence; j--)
+			if (j < k) best[j] = best[j - 1];
+		best[j] = { influence, i };
+		found = std::min(found + 1, k);
+	}
+
+	LightSet set = 0;
+	for (size_t j = 0; j < found; j++)
+		set |= LightSet(1) << best[j].index;
+	return set;
+}
+
+size_t game::select_frame_lights(const Vector3 *viewpoints, size_t n_viewpoints, double reach,
+	const PointLightComponent *lights, size_t n, size_t k, std::vector<PointLightComponent> &out)
+{
+	struct Candidate { double influence; size_t index; };
+	thread_local std::vector<Candidate> candidates;
+	candidates.clear();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		if (!lights[i].on) continue;
+
+		//With no viewpoints, lights are ranked by their peak brightness alone
+		double distance = n_viewpoints > 0 ? std::numeric_limits<double>::infinity() : 0;
+		for (size_t v = 0; v < n_viewpoints; v++)
+		{
+			Vector3 d = lights[i].position - viewpoints[v];
+			distance = std::min(distance, std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z));
+		}
+
+		if (distance - light_range(lights[i]) > reach) continue;
+		candidates.push_back({ light_influence(lights[i], distance), i });
+	}
+
+	//Ties keep the order given, so the choice doesn't flicker between frames
+	size_t kept = std::min(k, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(), [](const Candidate &a, const Candidate &b) {
+		return a.influence > b.influence || (a.influence == b.influence && a.index < b.index);
+	});
+
+	for (size_t j = 0; j < kept; j++)
+		out.push_back(lights[candidates[j].index]);
+	return kept;
+}
@@ -0,0 +1,44 @@
+/**
+ * LightSelection.h
+ * Declares the functions choosing which point lights shade
+ * each object, by their influence over its bounds.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Components.h"
+#include "LightClusters.h"
+
+namespace game
+{
+	//Set of point lights, by their positions in the frame's array of lights
+	using LightSet = std::uint64_t;
+
+	//Most point lights a set can hold
+	constexpr size_t LIGHT_SET_CAPACITY = 64;
+
+	//Brightness below which a light is taken to have no effect
+	constexpr double LIGHT_CUTOFF = 1.0 / 256.0;
+
+	//Gets the brightness a point light gives at the given distance, before its colour
+	double light_influence(const PointLightComponent &light, double distance);
+
+	//Gets the distance beyond which a point light is dimmer than LIGHT_CUTOFF, which may be infinite
+	double light_range(const PointLightComponent &light);
+
+	//Gets a point light as LightClusters bins it
+	LightClusters::Light cluster_light(const PointLightComponent &light);
+
+	//Chooses the at most k point lights brightest anywhere on the given sphere, ignoring those
+	//too dim to matter. Only the first LIGHT_SET_CAPACITY lights are considered
+	LightSet select_lights(Vector3 centre, double radius, const PointLightComponent *lights, size_t n, size_t k);
+
+	//Appends the at most k point lights to shade a frame seen from the given viewpoints to out, brightest
+	//at their nearest viewpoint first, returning how many. Lights that are off, or whose range ends further
+	//than reach from every viewpoint, are left out
+	size_t select_frame_lights(const Vector3 *viewpoints, size_t n_viewpoints, double reach,
+		const PointLightComponent *lights, size_t n, size_t k, std::vector<PointLightComponent> &out);
+}
@@ -0,0 +1,154 @@
+/**
+ * Narrowphase.cpp
+ * Implements the Narrowphase class, which tests candidate pairs
+ * of spheres in batches and tracks which are in contact.
+ */
+
+#include "Narrowphase.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NARROWPHASE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//Pairs tested at once
+	constexpr size_t BATCH = 4;
+
+	double dot(game::Vector3 a, game::Vector3 b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//Gets the earliest fraction of the motion at which a sphere of the given radius, starting at offset,
+	//reaches the origin, or a negative number if it never does
+	double time_of_impact(game::Vector3 offset, game::Vector3 motion, double radius)
+	{
+		//Solve |offset + motion * t|^2 = radius^2 for the smaller root
+		double c = dot(offset, offset) - radius * radius;
+		if (c < 0) return 0;
+
+		double a = dot(motion, motion);
+		double b = dot(offset, motion);
+		double discriminant = b * b - a * c;
+		if (a == 0 || b >= 0 || discriminant < 0) return -1;
+
+		double t = (-b - std::sqrt(discriminant)) / a;
+		return t <= 1 ? t : -1;
+	}
+}
+
+void game::Narrowphase::begin()
+{
+	pairs_.clear();
+	dx_.clear();
+	dy_.clear();
+	dz_.clear();
+	r_.clear();
+	sweeps_.clear();
+}
+
+void game::Narrowphase::add(EntityPair pair, Vector3 a, Vector3 b, double radius)
+{
+	//Offsets are taken in double precision, so distant pairs lose nothing to floats
+	pairs_.push_back(pair);
+	dx_.push_back(static_cast<float>(b.x - a.x));
+	dy_.push_back(static_cast<float>(b.y - a.y));
+	dz_.push_back(static_cast<float>(b.z - a.z));
+	r_.push_back(static_cast<float>(radius));
+}
+
+void game::Narrowphase::add_swept(EntityPair pair, Vector3 a_old, Vector3 a, Vector3 b_old, Vector3 b, double radius)
+{
+	//Sweep b relative to a, so only one sphere moves
+	Vector3 offset = b_old - a_old;
+	sweeps_.push_back({ pair, offset, (b - a) - offset, radius });
+}
+
+void game::Narrowphase::test()
+{
+	size_t n = pairs_.size();
+
+	//Pad to whole batches with pairs which never overlap (nothing is nearer than zero)
+	size_t padded = (n + BATCH - 1) / BATCH * BATCH;
+	dx_.resize(padded, 0.0f);
+	dy_.resize(padded, 0.0f);
+	dz_.resize(padded, 0.0f);
+	r_.resize(padded, 0.0f);
+	hits_.resize(padded);
+
+#ifdef NARROWPHASE_SSE
+	for (size_t i = 0; i < padded; i += BATCH)
+	{
+		__m128 dx = _mm_loadu_ps(&dx_[i]);
+		__m128 dy = _mm_loadu_ps(&dy_[i]);
+		__m128 dz = _mm_loadu_ps(&dz_[i]);
+		__m128 r = _mm_loadu_ps(&r_[i]);
+
+		//Compare squared distances, so no square roots are needed
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(d2, _mm_mul_ps(r, r)));
+		for (size_t k = 0; k < BATCH; k++)
+			hits_[i + k] = (mask >> k) & 1;
+	}
+#else
+	for (size_t i = 0; i < padded; i++)
+	{
+		float d2 = dx_[i] * dx_[i] + dy_[i] * dy_[i] + dz_[i] * dz_[i];
+		hits_[i] = d2 < r_[i] * r_[i];
+	}
+#endif
+}
+
+void game::Narrowphase::finish()
+{
+	test();
+
+	enter.clear();
+	enter_time.clear();
+	stay.clear();
+	leave.clear();
+
+	//Refresh the stamp of every pair found touching; whatever is left unrefreshed has come apart
+	contacts_.begin_frame();
+	for (size_t i = 0; i < pairs_.size(); i++)
+		if (hits_[i])
+		{
+			if (contacts_.touch(pairs_[i]))
+				stay.push_back(pairs_[i]);
+			else
+			{
+				enter.push_back(pairs_[i]);
+				enter_time.push_back(1);
+			}
+		}
+
+	//Swept pairs are few, so are tested one at a time
+	for (auto &s : sweeps_)
+	{
+		double t = time_of_impact(s.offset, s.motion, s.radius);
+		if (t < 0) continue;
+
+		if (contacts_.touch(s.pair))
+			stay.push_back(s.pair);
+		else
+		{
+			enter.push_back(s.pair);
+			enter_time.push_back(t);
+		}
+	}
+
+	contacts_.sweep(leave);
+}
+
+void game::Narrowphase::clear()
+{
+	contacts_.clear();
+	enter.clear();
+	enter_time.clear();
+	stay.clear();
+	leave.clear();
+}
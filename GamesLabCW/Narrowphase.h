@@ -0,0 +1,76 @@
+/**
+ * Narrowphase.h
+ * Declares the Narrowphase class, which tests candidate pairs
+ * of spheres in batches and tracks which are in contact.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Broadphase.h"
+#include "ContactTable.h"
+
+namespace game
+{
+	class Narrowphase
+	{
+	private:
+		//Candidate pairs
+		std::vector<EntityPair> pairs_;
+
+		//Offset between each pair's centres and the sum of their radii, as separate arrays
+		//padded to the batch width, so pairs are tested several at a time
+		std::vector<float> dx_, dy_, dz_, r_;
+
+		//Whether each candidate pair's spheres overlap
+		std::vector<std::uint8_t> hits_;
+
+		//Candidate pair swept through the tick, by the offset between its centres at the start
+		//and how far that offset moves by the end
+		struct Sweep
+		{
+			EntityPair pair;
+			Vector3 offset;
+			Vector3 motion;
+			double radius;
+		};
+		std::vector<Sweep> sweeps_;
+
+		//Pairs in contact, stamped with the latest run to find them so
+		ContactTable contacts_;
+
+		//Sets hits_ for every candidate pair
+		void test();
+
+	public:
+		//Pairs which came into, stayed in and left contact during the latest run
+		std::vector<EntityPair> enter, stay, leave;
+
+		//Fraction of the tick through which each pair in enter first touched. Pairs only tested
+		//at the end of the tick entered at 1
+		std::vector<double> enter_time;
+
+		//Starts a run, forgetting the previous candidates
+		void begin();
+
+		//Adds a candidate pair, whose spheres overlap when their centres are nearer than radius.
+		//Each pair may be added once per run, in any order
+		void add(EntityPair pair, Vector3 a, Vector3 b, double radius);
+
+		//Adds a candidate pair moving in straight lines from a_old and b_old to a and b during the tick,
+		//in contact if they touch at any point along the way, so fast pairs can't pass through each other
+		void add_swept(EntityPair pair, Vector3 a_old, Vector3 a, Vector3 b_old, Vector3 b, double radius);
+
+		//Tests every candidate, sorting them into enter and stay against the previous contacts.
+		//Contacts not found again this run, whether or not they were candidates, leave
+		void finish();
+
+		//Gets the pairs in contact as of the latest run
+		const ContactTable &contacts() const { return contacts_; }
+
+		//Forgets all contacts
+		void clear();
+	};
+}
@@ -23,8 +23,6 @@ void game::prototypes::register_prototypes()
 
 	PROTOTYPE(ParticleEffect, ParticleComponent, ColourComponent, TransformComponent, KinematicComponent);
 
-	PROTOTYPE(Overlay, OverlayComponent);
-
 	PROTOTYPE(Key, ModelComponent, ColourComponent, CollisionComponent, TransformComponent, KeyComponent, PointLightComponent, KinematicComponent);
 
 	PROTOTYPE(AmbientLight, AmbientLightComponent);
@@ -40,5 +38,14 @@ void game::prototypes::register_prototypes()
 	PROTOTYPE(Portal, PortalComponent, CollisionComponent, TransformComponent);
 
 	PROTOTYPE(Door, DoorComponent, CollisionComponent, TransformComponent);
+
+	//Collision spheres and layers, so only pairs with a response are ever tested
+	using namespace layers;
+	prototypes.at("FirstPersonController").set<CollisionComponent>(6.0, Player, Enemy | Bullet | Pickup | Trigger);
+	prototypes.at("AIModel").set<CollisionComponent>(1.0, Enemy, Player | Bullet);
+	prototypes.at("Bullet").set<CollisionComponent>(5.0, Bullet, Player | Enemy, true);
+	prototypes.at("Key").set<CollisionComponent>(3.0, Pickup, Player);
+	prototypes.at("Portal").set<CollisionComponent>(3.0, Trigger, Player);
+	prototypes.at("Door").set<CollisionComponent>(3.0, Trigger, Player);
 }
 
@@ -6,27 +6,107 @@
 
 #include "Scene.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "Systems.h"
+#include "Scheduler.h"
+#include "CommandBuffer.h"
+#include "Jobs.h"
+#include "LightSelection.h"
 #include "Prototypes.h"
 #include "renderer/Renderer.h"
 #include "Utility.h"
 
-game::Scene::Scene()
+namespace
+{
+	//Rays handed to each job by raycast_many
+	constexpr size_t RAYCAST_GRAIN = 64;
+
+	//Models handed to each job when choosing their lights
+	constexpr size_t LIGHT_SELECTION_GRAIN = 64;
+
+	//A model to draw this frame, with the point lights chosen to shade it
+	struct Drawable
+	{
+		game::ModelComponent *model;
+		game::ColourComponent colour;
+		game::TransformComponent transform;
+		game::LightSet lights;
+	};
+
+	double dot(game::Vector3 a, game::Vector3 b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//Gets the distance along a ray to where it enters a sphere, or a negative number if it misses
+	double ray_sphere(const game::Ray &ray, game::Vector3 centre, double radius)
+	{
+		game::Vector3 m = ray.origin - centre;
+		double b = dot(m, ray.direction);
+		double c = dot(m, m) - radius * radius;
+
+		//Starting inside counts as a hit straight away
+		if (c <= 0) return 0;
+		if (b > 0) return -1;
+
+		double discriminant = b * b - c;
+		return discriminant < 0 ? -1 : -b - std::sqrt(discriminant);
+	}
+
+	//Gets the distance along a ray to where it crosses a solid plane, or a negative number if it misses
+	double ray_plane(const game::Ray &ray, const game::StaticGeometry::Plane &plane)
+	{
+		double facing = dot(ray.direction, plane.normal);
+		if (facing == 0) return -1;
+
+		double t = dot(plane.position - ray.origin, plane.normal) / facing;
+		if (t < 0) return -1;
+
+		//Planes reach their size from their centre line, as SolidPlaneSystem has them
+		game::Vector3 point = ray.origin + ray.direction * t;
+		game::Vector3 centre = plane.position;
+		double span2 = dot(plane.span, plane.span);
+		if (span2 > 0)
+			centre += plane.span * std::clamp(dot(point - centre, plane.span) / span2, -1.0, 1.0);
+
+		game::Vector3 d = point - centre;
+		return dot(d, d) <= plane.size * plane.size ? t : -1;
+	}
+}
+
+game::Scene::Scene(Broadphase::Kind broadphase) :
+	scheduler_(std::make_unique<systems::Scheduler>()),
+	commands_(jobs::worker_count() + 1),
+	broadphase_(Broadphase::create(broadphase))
 {
 	create(GameStateComponent());
 }
 
+game::Scene::~Scene() = default;
+
 void game::Scene::tick(double dt)
 {
-	//Invoke all systems
-	for (auto &s : systems::system_invokers)
-		s({ *this, dt, registry_ }, registry_);
+	//Give every thread which may run a system its own command buffer, including workers started since construction
+	if (commands_.size() < jobs::worker_count() + 1)
+		commands_.resize(jobs::worker_count() + 1);
+
+	//Invoke all systems, in parallel where they don't conflict
+	scheduler_->run({ *this, dt, registry_ }, registry_);
+
+	//Make the structural changes recorded by systems
+	CommandBuffer::apply(commands_, *this);
+
+	//Reflect the player's latest stats on the HUD
+	hud.update(registry_, dt);
 
 	//Broadcast all queued events
 	events::dispatcher.update();
 }
 
-void game::Scene::draw()
+void game::Scene::draw(double alpha)
 {
 	//Get all ambient lights
 	size_t n_a = registry_.raw_view<AmbientLightComponent>().size();
@@ -40,55 +120,161 @@ void game::Scene::draw()
 	size_t n_p = registry_.raw_view<PointLightComponent>().size();
 	PointLightComponent *p = registry_.raw_view<PointLightComponent>().raw();
 
-	//Filter point lights to nearby only
-	std::vector<PointLightComponent> nearby;
-	if (CULL_POINT_LIGHTS)
+	//Gets the transform of an entity as it stood alpha of the way through the latest tick
+	auto interpolated = [&](Entity e, TransformComponent t)
+	{
+		if (registry_.has<KinematicComponent>(e))
+			t.position = t.position_old + (t.position - t.position_old) * alpha;
+		return t;
+	};
+
+	//Gets a camera as it stands this frame, at the entity it follows if any
+	auto placed = [&](CameraComponent cam)
 	{
-		auto player = registry_.view<FirstPersonControllerComponent>();
-		if (drawn_yet && player.size() > 0)
+		if (registry_.valid(cam.follow) && registry_.has<TransformComponent>(cam.follow))
+			cam.position = interpolated(cam.follow, registry_.get<TransformComponent>(cam.follow)).position;
+		return cam;
+	};
+
+	//Choose the frame's point lights from all of them by how brightly they reach the cameras, as only
+	//so many can be uploaded, leaving out those too short-ranged to light anything drawn
+	thread_local std::vector<Vector3> viewpoints;
+	viewpoints.clear();
+	registry_.view<CameraComponent>().each([&](auto, auto &cam) { viewpoints.push_back(placed(cam).position); });
+
+	thread_local std::vector<PointLightComponent> chosen;
+	chosen.clear();
+	double reach = CULL_POINT_LIGHTS ? RENDER_DISTANCE : std::numeric_limits<double>::infinity();
+	n_p = select_frame_lights(viewpoints.data(), viewpoints.size(), reach, p, n_p, MAX_POINT_LIGHTS, chosen);
+	p = chosen.data();
+
+	//Lights are the same for every model, so are sent once for the frame
+	renderer::upload_lights(n_a, a, n_d, d, n_p, p);
+
+	//Gather the models to draw
+	thread_local std::vector<Drawable> drawables;
+	drawables.clear();
+	registry_.view<ModelComponent, ColourComponent, TransformComponent>().each([&](auto e, auto &m, auto &c, auto &t) {
+		drawables.push_back({ &m, c, interpolated(e, t), 0 });
+	});
+
+	//Choose the lights of each from its bounds, out of the frame's
+	jobs::parallel_for(0, drawables.size(), LIGHT_SELECTION_GRAIN, [&](size_t i) {
+		Drawable &o = drawables[i];
+		Vector3 s = o.transform.scale;
+		double scale = std::max({ std::abs(s.x), std::abs(s.y), std::abs(s.z) });
+		double radius = renderer::model_radius(o.model->model_file) * scale;
+		o.lights = select_lights(o.transform.position, radius, p, n_p, MAX_OBJECT_LIGHTS);
+	});
+
+	//Render all models in the scene for each camera
+	registry_.view<CameraComponent>().each([&](auto, auto &camera) {
+		CameraComponent cam = placed(camera);
+
+		renderer::upload_light_clusters(cam, n_p, p);
+
+		for (auto &o : drawables)
+			renderer::render_model(cam, *o.model, o.colour, o.transform, o.lights);
+
+		registry_.view<ParticleComponent, ColourComponent, TransformComponent>().each([&](auto e, auto &p, auto &c, auto &t) {
+			renderer::render_particle(cam, p, c, interpolated(e, t));
+		});
+	});
+
+	//Draw the HUD over everything
+	hud.draw();
+
+	drawn_yet = true;
+}
+
+bool game::Scene::raycast(const Ray &ray, LayerMask mask, RayHit &hit) const
+{
+	hit = RayHit();
+	hit.distance = ray.length;
+
+	Vector3 end = ray.origin + ray.direction * ray.length;
+	Vector3 lo = { std::min(ray.origin.x, end.x), std::min(ray.origin.y, end.y), std::min(ray.origin.z, end.z) };
+	Vector3 hi = { std::max(ray.origin.x, end.x), std::max(ray.origin.y, end.y), std::max(ray.origin.z, end.z) };
+
+	//Colliders whose bounds overlap the box around the ray
+	thread_local std::vector<Entity> candidates;
+	candidates.clear();
+	broadphase_->query_box(lo, hi, candidates, mask);
+
+	for (auto e : candidates)
+	{
+		if (e == ray.ignore || !registry_.valid(e) || !registry_.has<CollisionComponent, TransformComponent>(e))
+			continue;
+
+		const auto &c = registry_.get<CollisionComponent>(e);
+		double t = ray_sphere(ray, registry_.get<TransformComponent>(e).position, c.radius);
+		if ((c.layer & mask) && t >= 0 && t <= hit.distance)
 		{
-			auto t_player = registry_.get<TransformComponent>(*player.begin());
-			nearby.reserve(n_p);
-			for (int i = 0; i < n_p; i++)
-			{
-				Vector3 to_player = p[i].position - t_player.position;
-				double dist = to_player.x * to_player.x +
-					to_player.y * to_player.y +
-					to_player.z * to_player.z;
-
-				double dist_max = RENDER_DISTANCE - 100.0;
-				if (dist < dist_max * dist_max)
-					nearby.emplace_back(p[i]);
-			}
+			hit.hit = true;
+			hit.entity = e;
+			hit.distance = t;
+		}
+	}
 
-			//Update data, ensuring at least one point light is passed in
-			if (nearby.size() > 0)
+	//Solid planes nearer than any collider
+	if (mask & layers::Wall)
+	{
+		thread_local std::vector<std::uint32_t> planes;
+		planes.clear();
+		static_geometry_.query(lo, hi, planes);
+
+		for (auto i : planes)
+		{
+			double t = ray_plane(ray, static_geometry_.plane(i));
+			if (t >= 0 && t <= hit.distance)
 			{
-				n_p = nearby.size();
-				p = nearby.data();
+				hit.hit = true;
+				hit.entity = entt::null;
+				hit.distance = t;
 			}
-			else if (n_p > 0)
-				n_p = 1;
 		}
 	}
 
-	//Render all models in the scene for each camera
-	registry_.view<CameraComponent>().each([&](auto, auto &cam) {
-		registry_.view<ModelComponent, ColourComponent, TransformComponent>().each([&](auto, auto &m, auto &c, auto &t) {
-			renderer::render_model(cam, m, c, t,
-				n_a, a, n_d, d, n_p, p);
-		});
-
-		registry_.view<ParticleComponent, ColourComponent, TransformComponent>().each([&](auto, auto &p, auto &c, auto &t) {
-			renderer::render_particle(cam, p, c, t);
-		});
+	hit.point = ray.origin + ray.direction * hit.distance;
+	return hit.hit;
+}
 
-		registry_.view<OverlayComponent>().each([&](auto, auto &i) {
-			renderer::render_overlay(cam, i);
-		});
+void game::Scene::raycast_many(const std::vector<Ray> &rays, LayerMask mask, std::vector<RayHit> &hits) const
+{
+	hits.resize(rays.size());
+	jobs::parallel_for(0, rays.size(), RAYCAST_GRAIN, [&](size_t i) {
+		raycast(rays[i], mask, hits[i]);
 	});
+}
 
-	drawn_yet = true;
+size_t game::Scene::overlap_sphere(Vector3 centre, double radius, LayerMask mask, std::vector<Entity> &out) const
+{
+	thread_local std::vector<Entity> candidates;
+	candidates.clear();
+	broadphase_->query(centre, radius, candidates, mask);
+
+	size_t n = 0;
+	for (auto e : candidates)
+	{
+		if (!registry_.valid(e) || !registry_.has<CollisionComponent, TransformComponent>(e))
+			continue;
+
+		const auto &c = registry_.get<CollisionComponent>(e);
+		Vector3 d = registry_.get<TransformComponent>(e).position - centre;
+		double r = radius + c.radius;
+		if ((c.layer & mask) && dot(d, d) < r * r)
+		{
+			out.push_back(e);
+			n++;
+		}
+	}
+
+	return n;
+}
+
+game::CommandBuffer &game::Scene::commands()
+{
+	return commands_[jobs::thread_index()];
 }
 
 game::Entity game::Scene::instantiate(std::initializer_list<std::string> p)
@@ -100,15 +286,53 @@ game::Entity game::Scene::instantiate(std::initializer_list<std::string> p)
 	return e;
 }
 
+void game::Scene::settle(Entity e)
+{
+	if (registry_.has<TransformComponent>(e))
+	{
+		auto &t = registry_.get<TransformComponent>(e);
+		t.position_old = t.position;
+	}
+
+	if (registry_.has<SolidPlaneComponent>(e))
+		static_geometry_.invalidate();
+
+	if (registry_.has<CollisionComponent>(e) && !registry_.has<KinematicComponent>(e))
+		broadphase_->invalidate_static();
+}
+
+void game::Scene::assigned(entt::registry<>::component_type type)
+{
+	if (type == entt::registry<>::type<SolidPlaneComponent>())
+		static_geometry_.invalidate();
+
+	//Colliders are static unless kinematic, so either may move an entity between the broadphase's sets
+	if (type == entt::registry<>::type<CollisionComponent>() || type == entt::registry<>::type<KinematicComponent>())
+		broadphase_->invalidate_static();
+}
+
 void game::Scene::destroy(Entity e)
 {
+	//Entity identifiers are recycled, so mustn't linger in the broadphase
+	broadphase_->remove(e);
+
+	if (registry_.has<SolidPlaneComponent>(e))
+		static_geometry_.invalidate();
+
+	if (registry_.has<CollisionComponent>(e) && !registry_.has<KinematicComponent>(e))
+		broadphase_->invalidate_static();
+
 	registry_.destroy(e);
 }
 
 void game::Scene::clear()
 {
 	registry_.reset();
-	spatial_grid.clear();
+	broadphase_->clear();
+	broadphase_->invalidate_static();
+	static_geometry_.invalidate();
+	narrowphase.clear();
+	hud.invalidate();
 	drawn_yet = false;
 
 	create(GameStateComponent());
@@ -6,36 +6,115 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
 #include <entt/entt.hpp>
 
-#include "SpatialGrid.h"
+#include "Broadphase.h"
+#include "Narrowphase.h"
+#include "StaticGeometry.h"
+#include "Hud.h"
 
 namespace game
 {
+	namespace systems { class Scheduler; }
+	class CommandBuffer;
+
 	//Numerical type representing individual entities
 	using Entity = entt::registry<>::entity_type;
 
+	//Ray from an origin along a unit direction, as far as the given length
+	struct Ray
+	{
+		Vector3 origin;
+		Vector3 direction;
+		double length;
+		Entity ignore = entt::null; //Entity the ray passes through, e.g. the one casting it
+	};
+
+	//Nearest thing hit by a ray
+	struct RayHit
+	{
+		bool hit = false;
+		Entity entity = entt::null; //Entity hit, or null for a solid plane
+		double distance = 0;
+		Vector3 point;
+	};
+
 	class Scene
 	{
 	private:
 		//Registry of entities
 		entt::registry<> registry_;
 
+		//Runs the logic systems each tick
+		std::unique_ptr<systems::Scheduler> scheduler_;
+
+		//Structural changes recorded during the tick, one buffer per job system thread
+		std::vector<CommandBuffer> commands_;
+
+		//Narrows down potential collisions between entities
+		std::unique_ptr<Broadphase> broadphase_;
+
+		//Solid planes of the level, indexed by position
+		StaticGeometry static_geometry_;
+
 		//Has this scene been drawn yet after the last clear?
 		bool drawn_yet = false;
 
+		//Marks a newly placed entity as stationary, so it isn't interpolated in from the origin,
+		//and has the static geometry indexed again if it is part of it
+		void settle(Entity e);
+
+		//Has the static geometry or static colliders indexed again if a component of the given type
+		//assigned to an entity may change them
+		void assigned(entt::registry<>::component_type type);
+
 	public:
-		//Spatial partitioning grid of entities
-		SpatialGrid<Entity> spatial_grid;
+		//Entities in contact, and the changes found by the latest collision tests
+		Narrowphase narrowphase;
 
-		//Default constructor
-		Scene();
+		//Heads-up display drawn over the scene
+		Hud hud;
+
+		//Creates an empty scene, detecting collisions with the given kind of broadphase
+		Scene(Broadphase::Kind broadphase = Broadphase::Kind::SweepAndPrune);
+
+		//Destructor, stopping the scheduler's workers
+		~Scene();
 
 		//Ticks all logic systems in this Scene
 		void tick(double dt);
 
-		//Invokes the render systems in this Scene
-		void draw();
+		//Gets the scheduler running the logic systems
+		systems::Scheduler &scheduler() { return *scheduler_; }
+
+		//Gets the calling thread's buffer of structural changes, applied at the end of the tick
+		CommandBuffer &commands();
+
+		//Gets the broadphase of potentially colliding entities
+		Broadphase &broadphase() { return *broadphase_; }
+
+		//Gets the index of the level's solid planes, rebuilt by StaticGeometrySystem when out of date
+		StaticGeometry &static_geometry() { return static_geometry_; }
+		const StaticGeometry &static_geometry() const { return static_geometry_; }
+
+		//Gets the registry of entities, for inspection
+		const entt::registry<> &registry() const { return registry_; }
+
+		//Finds the nearest collider on a layer in mask hit by the ray, or solid plane if mask includes layers::Wall.
+		//Queries read colliders and static geometry, so systems making them should declare
+		//Reads<CollisionComponent, TransformComponent, resource::Broadphase, resource::StaticGeometry>
+		bool raycast(const Ray &ray, LayerMask mask, RayHit &hit) const;
+
+		//Casts every ray, writing the hit of each to the same position in hits, spread across the job system
+		void raycast_many(const std::vector<Ray> &rays, LayerMask mask, std::vector<RayHit> &hits) const;
+
+		//Appends each collider on a layer in mask whose sphere overlaps the given one to out, returning how many
+		size_t overlap_sphere(Vector3 centre, double radius, LayerMask mask, std::vector<Entity> &out) const;
+
+		//Invokes the render systems in this Scene, interpolating alpha of the way through the latest tick
+		void draw(double alpha = 1.0);
 
 		//Default-instantiates an entity of the given prototype
 		Entity instantiate(std::string p) { return instantiate({ p }); }
@@ -53,6 +132,7 @@ namespace game
 		{
 			auto e = instantiate(p);
 			(registry_.replace<Ts>(e, components), ...);
+			settle(e);
 			return e;
 		}
 
@@ -62,6 +142,7 @@ namespace game
 		{
 			auto e = registry_.create();
 			(registry_.assign_or_replace<Ts>(e, components), ...);
+			settle(e);
 			return e;
 		}
 
@@ -70,6 +151,7 @@ namespace game
 		void add(Entity e, T component)
 		{
 			registry_.assign_or_replace<T>(e, component);
+			assigned(entt::registry<>::type<T>());
 		}
 
 		//Gets the given component of the given entity
@@ -79,6 +161,9 @@ namespace game
 			return registry_.get<T>(e);
 		}
 
+		//Is the given entity still alive?
+		bool valid(Entity e) const { return registry_.valid(e); }
+
 		//Destroys the given entity
 		void destroy(Entity e);
 
@@ -98,5 +183,12 @@ namespace game
 
 		//The registry in use
 		entt::registry<> &registry;
+
+		//Share of the system's entities to visit this run, of the given number (see Slices)
+		size_t slice = 0;
+		size_t slices = 1;
+
+		//Gets the calling thread's buffer of structural changes, applied at the end of the tick
+		CommandBuffer &commands() const { return scene.commands(); }
 	};
 }
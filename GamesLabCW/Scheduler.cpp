@@ -0,0 +1,199 @@
+/**
+ * Scheduler.cpp
+ * Implements the Scheduler class, which runs systems that don't
+ * conflict over components or resources in parallel.
+ */
+
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "Jobs.h"
+
+namespace
+{
+	//Least simulated seconds between reports of the same system overrunning
+	constexpr double REPORT_INTERVAL = 5.0;
+
+	//Tolerance when deciding whether a rate-limited system is due
+	constexpr double DUE_EPSILON = 1e-6;
+
+	//Whether any type is common to both lists
+	bool overlaps(const std::vector<game::systems::AccessType> &a, const std::vector<game::systems::AccessType> &b)
+	{
+		for (auto t : a)
+			if (std::find(b.begin(), b.end(), t) != b.end())
+				return true;
+		return false;
+	}
+}
+
+bool game::systems::Access::conflicts(const Access &other) const
+{
+	return exclusive || other.exclusive ||
+		overlaps(writes, other.writes) ||
+		overlaps(writes, other.reads) ||
+		overlaps(reads, other.writes);
+}
+
+void game::systems::Scheduler::build()
+{
+	stages_.clear();
+
+	std::vector<Access> access;
+	for (auto &s : system_invokers)
+		access.push_back(s.access());
+
+	//Place each system one stage after the latest earlier system it conflicts with
+	std::vector<size_t> stage_of(system_invokers.size());
+	for (size_t i = 0; i < system_invokers.size(); i++)
+	{
+		size_t stage = 0;
+		for (size_t j = 0; j < i; j++)
+			if (access[i].conflicts(access[j]))
+				stage = std::max(stage, stage_of[j] + 1);
+
+		stage_of[i] = stage;
+		if (stage == stages_.size())
+			stages_.emplace_back();
+		stages_[stage].push_back(i);
+	}
+
+	states_.assign(system_invokers.size(), State());
+	for (size_t i = 0; i < states_.size(); i++)
+	{
+		states_[i].timing = system_invokers[i].timing();
+
+		//Budgeted systems start whole, and only split when they overrun
+		if (states_[i].timing.budget == 0)
+			states_[i].slices = states_[i].timing.slices;
+	}
+
+	n_built_ = system_invokers.size();
+}
+
+void game::systems::Scheduler::invoke(size_t i, SceneInfo info, entt::registry<> &reg)
+{
+	State &s = states_[i];
+
+	//Each entity was last visited a full round of slices ago
+	info.dt = s.elapsed * s.slices;
+	info.slice = s.slice;
+	info.slices = s.slices;
+
+	auto start = std::chrono::steady_clock::now();
+	system_invokers[i].invoke(info, reg);
+	s.cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void game::systems::Scheduler::finish(size_t i)
+{
+	State &s = states_[i];
+
+	s.elapsed = 0;
+	if (s.timing.rate > 0)
+		s.owed = std::min(s.owed - 1.0, 1.0);
+	s.slice = (s.slice + 1) % s.slices;
+
+	if (s.timing.budget == 0)
+		return;
+
+	if (s.cost > s.timing.budget)
+	{
+		s.overruns++;
+		if (time_ - s.reported >= REPORT_INTERVAL)
+		{
+			std::cout << "System " << system_invokers[i].name << " overran its budget: "
+				<< s.cost * 1e6 << "us of " << s.timing.budget * 1e6 << "us ("
+				<< s.overruns << " overruns, " << s.slices << " slices)" << std::endl;
+			s.reported = time_;
+		}
+
+		//Spread the entities over more runs, if allowed
+		if (s.slices < s.timing.slices)
+			s.slices = std::min(s.slices * 2, s.timing.slices);
+	}
+	//Merge slices back once comfortably under budget, leaving room for the cost to double
+	else if (s.slices > 1 && s.cost < s.timing.budget / 4)
+		s.slices /= 2;
+
+	s.slice %= s.slices;
+}
+
+void game::systems::Scheduler::run(SceneInfo info, entt::registry<> &reg)
+{
+	if (n_built_ != system_invokers.size())
+		build();
+
+	//Create component pools up front, as the registry can't safely grow during a stage
+	for (auto &s : system_invokers)
+		s.prepare(reg);
+
+	time_ += info.dt;
+	for (auto &s : states_)
+	{
+		s.elapsed += info.dt;
+		s.owed += info.dt * s.timing.rate;
+	}
+
+	for (auto &stage : stages_)
+	{
+		due_.clear();
+		for (auto i : stage)
+			if (states_[i].timing.rate == 0 || states_[i].owed >= 1.0 - DUE_EPSILON)
+				due_.push_back(i);
+
+		//Lone systems, and everything if there are no workers, run inline
+		if (due_.size() <= 1 || jobs::worker_count() == 0)
+		{
+			for (auto i : due_)
+				invoke(i, info, reg);
+		}
+		else
+		{
+			//Hand all but the first system to the job system, helping out with that one
+			jobs::Counter counter;
+			for (size_t k = 1; k < due_.size(); k++)
+			{
+				size_t i = due_[k];
+				jobs::run([this, i, info, &reg] { invoke(i, info, reg); }, &counter);
+			}
+			invoke(due_[0], info, reg);
+
+			jobs::wait(counter);
+		}
+
+		for (auto i : due_)
+			finish(i);
+	}
+}
+
+void game::systems::Scheduler::log(std::ostream &os)
+{
+	if (n_built_ != system_invokers.size())
+		build();
+
+	os << "System schedule (" << jobs::worker_count() << " workers):" << std::endl;
+	for (size_t s = 0; s < stages_.size(); s++)
+	{
+		os << "  " << s << ":";
+		for (auto i : stages_[s])
+			os << " " << system_invokers[i].name;
+		os << std::endl;
+	}
+
+	for (size_t i = 0; i < states_.size(); i++)
+	{
+		const Timing &t = states_[i].timing;
+		if (t.rate == 0 && t.slices == 1 && t.budget == 0)
+			continue;
+
+		os << "  " << system_invokers[i].name << ":";
+		if (t.rate > 0) os << " " << t.rate << "Hz";
+		if (t.slices > 1) os << " " << t.slices << " slices" << (t.budget > 0 ? " max" : "");
+		if (t.budget > 0) os << " " << t.budget * 1e6 << "us budget";
+		os << std::endl;
+	}
+}
@@ -0,0 +1,73 @@
+/**
+ * Scheduler.h
+ * Declares the Scheduler class, which runs systems that don't
+ * conflict over components or resources in parallel.
+ */
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "Systems.h"
+
+namespace game::systems
+{
+	class Scheduler
+	{
+	private:
+		//Progress of a system against its declared timing
+		struct State
+		{
+			Timing timing;
+
+			//Seconds since the system last ran
+			double elapsed = 0;
+
+			//Runs owed at the declared rate (carried over so uneven rates average out)
+			double owed = 0;
+
+			//Shares its entities are currently split into, and the next one to visit
+			size_t slices = 1;
+			size_t slice = 0;
+
+			//Seconds taken by the latest run
+			double cost = 0;
+
+			//Number of runs over budget, and the time the latest was reported
+			size_t overruns = 0;
+			double reported = -1e9;
+		};
+
+		//Groups of system indices which may run concurrently, in execution order
+		std::vector<std::vector<size_t>> stages_;
+
+		//Timing state of each registered system
+		std::vector<State> states_;
+
+		//Systems of the current stage due to run this tick
+		std::vector<size_t> due_;
+
+		//Simulated seconds since the scheduler started
+		double time_ = 0;
+
+		//Number of registered systems when the stages were last built
+		size_t n_built_ = 0;
+
+		//Groups systems into stages, keeping any two that conflict in registration order
+		void build();
+
+		//Runs one system with its accumulated dt and share of entities, timing it
+		void invoke(size_t i, SceneInfo info, entt::registry<> &reg);
+
+		//Resets a system's timing after it ran, adapting its slices to fit its budget
+		void finish(size_t i);
+
+	public:
+		//Runs every registered system which is due this tick
+		void run(SceneInfo info, entt::registry<> &reg);
+
+		//Writes the stage layout and system timings to the given stream
+		void log(std::ostream &os);
+	};
+}
@@ -6,8 +6,10 @@
 
 #pragma once
 
-#include <map>
-#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "Vector3.h"
 
@@ -17,85 +19,201 @@ namespace game
 	class SpatialGrid
 	{
 	public:
-		using value_type = typename T;
-		using index_type = std::tuple<int, int, int>;
-		using iterator = typename std::unordered_set<value_type>::iterator;
+		using value_type = T;
+
+		//Packed grid coordinates of a cell
+		using index_type = std::uint64_t;
+
+		//Index of no cell, e.g. for elements not yet inserted
+		static constexpr index_type none = ~index_type(0);
 
 	private:
-		std::map<index_type, std::unordered_set<value_type>> grid_;
-		Vector3 cell_size_ = { 40,40,40};
+		//Bits per packed coordinate, and the offset making coordinates unsigned
+		static constexpr int BITS = 21;
+		static constexpr std::int64_t BIAS = std::int64_t(1) << (BITS - 1);
+		static constexpr index_type MASK = (index_type(1) << BITS) - 1;
+
+		//Entry of the open-addressed table, mapping a cell index to its elements
+		struct Slot
+		{
+			index_type index = none;
+			std::uint32_t cell = 0;
+		};
+
+		//Power-of-two sized table of cells, probed linearly
+		std::vector<Slot> slots_ = std::vector<Slot>(64);
+
+		//Elements of each cell, stored contiguously
+		std::vector<std::vector<value_type>> cells_;
+
+		Vector3 cell_size_;
+
+		static index_type pack(std::int64_t x, std::int64_t y, std::int64_t z)
+		{
+			return (index_type(x + BIAS) & MASK) |
+				((index_type(y + BIAS) & MASK) << BITS) |
+				((index_type(z + BIAS) & MASK) << (2 * BITS));
+		}
+
+		static size_t hash(index_type i)
+		{
+			return size_t((i * 0x9E3779B97F4A7C15ull) >> 32);
+		}
+
+		//Gets the slot holding the given cell, or the empty slot it would occupy
+		size_t probe(index_type i) const
+		{
+			size_t mask = slots_.size() - 1;
+			size_t s = hash(i) & mask;
+			while (slots_[s].index != i && slots_[s].index != none)
+				s = (s + 1) & mask;
+			return s;
+		}
+
+		//Gets the elements of the given cell, or null if it has never held any
+		const std::vector<value_type> *find(index_type i) const
+		{
+			const Slot &slot = slots_[probe(i)];
+			return slot.index == none ? nullptr : &cells_[slot.cell];
+		}
+
+		std::vector<value_type> *find(index_type i)
+		{
+			const Slot &slot = slots_[probe(i)];
+			return slot.index == none ? nullptr : &cells_[slot.cell];
+		}
+
+		//Gets the elements of the given cell, creating it if need be
+		std::vector<value_type> &find_or_create(index_type i)
+		{
+			if (auto *cell = find(i))
+				return *cell;
+
+			//Keep the table at most half full
+			if ((cells_.size() + 1) * 2 > slots_.size())
+				rehash(slots_.size() * 2);
+
+			slots_[probe(i)] = { i, static_cast<std::uint32_t>(cells_.size()) };
+			return cells_.emplace_back();
+		}
+
+		void rehash(size_t capacity)
+		{
+			std::vector<Slot> old(capacity);
+			std::swap(old, slots_);
+
+			for (auto &slot : old)
+				if (slot.index != none)
+					slots_[probe(slot.index)] = slot;
+		}
+
+		//Gets the integer grid coordinate of a position along one axis
+		static std::int64_t coord(double v, double size)
+		{
+			std::int64_t c = static_cast<std::int64_t>(v / size);
+			if (v < 0.0) c--;
+			return c;
+		}
 
 	public:
-		//Inserts an element as per the given position vector
-		void insert(Vector3 v, value_type elt)
+		//Creates an empty grid of cells of the given size
+		explicit SpatialGrid(Vector3 cell_size = { 40,40,40 }) : cell_size_(cell_size) {}
+
+		//Inserts an element as per the given position vector, returning its cell
+		index_type insert(Vector3 v, value_type elt)
 		{
 			index_type i = index(v);
-			grid_[i].emplace(elt);
+			find_or_create(i).push_back(elt);
+			return i;
+		}
+
+		//Inserts an element into every cell overlapping the box between the given corners
+		void insert_in(Vector3 lo, Vector3 hi, value_type elt)
+		{
+			std::int64_t x0 = coord(lo.x, cell_size_.x), x1 = coord(hi.x, cell_size_.x);
+			std::int64_t y0 = coord(lo.y, cell_size_.y), y1 = coord(hi.y, cell_size_.y);
+			std::int64_t z0 = coord(lo.z, cell_size_.z), z1 = coord(hi.z, cell_size_.z);
+
+			for (auto x = x0; x <= x1; x++)
+				for (auto y = y0; y <= y1; y++)
+					for (auto z = z0; z <= z1; z++)
+						find_or_create(pack(x, y, z)).push_back(elt);
 		}
 
-		//Updates an element as per the given position vector
+		//Updates an element as per the given position vector, returning its new cell
 		index_type update(Vector3 v, value_type elt, index_type previous)
 		{
 			//New index
 			index_type i = index(v);
 
-			//If new index is different to previous, remove previous
-			if (i != previous)
-				grid_[previous].erase(elt);
+			//Only move if the cell has changed
+			if (i == previous)
+				return i;
 
-			//Add at new index
-			grid_[i].emplace(elt);
+			erase(previous, elt);
+			find_or_create(i).push_back(elt);
 
 			return i;
 		}
 
-		//Gets begin/end iterators of elements corresponding to the given position vector 
-		std::pair<iterator, iterator> get_cell(Vector3 v)
+		//Removes an element from the given cell, if present
+		void erase(index_type i, value_type elt)
 		{
-			auto &cell = grid_[index(v)];
-			return { cell.begin(), cell.end() };
+			if (i == none) return;
+
+			if (auto *cell = find(i))
+			{
+				auto it = std::find(cell->begin(), cell->end(), elt);
+				if (it != cell->end())
+				{
+					*it = cell->back();
+					cell->pop_back();
+				}
+			}
 		}
 
-		//Gets begin/end iterators of all neighbouring elements to the given position
-		std::pair<iterator, iterator> get_cells_near(Vector3 v)
+		//Gets begin/end pointers of elements corresponding to the given position vector
+		std::pair<const value_type*, const value_type*> get_cell(Vector3 v) const
 		{
-			//Union of all neighbouring cells' elements
-			static std::unordered_set<value_type> cells;
-			cells.clear();
+			auto *cell = find(index(v));
+			if (!cell) return { nullptr, nullptr };
+			return { cell->data(), cell->data() + cell->size() };
+		}
 
-			//Iteratively construct union over all immediate neighbours
-			for (int i = -1; i < 2; i++)
-				for (int j = -1; j < 2; j++)
-					for (int k = -1; k < 2; k++)
-					{
-						auto [x, y, z] = index(v);
-						index_type index = { x + i, y + j, z + k };
-						auto &cell = grid_[index];
-						cells.insert(cell.begin(), cell.end());
-					}
+		//Invokes f(element) for every element in the cells overlapping the box between the given corners
+		template <typename F>
+		void for_each_in(Vector3 lo, Vector3 hi, const F &f) const
+		{
+			std::int64_t x0 = coord(lo.x, cell_size_.x), x1 = coord(hi.x, cell_size_.x);
+			std::int64_t y0 = coord(lo.y, cell_size_.y), y1 = coord(hi.y, cell_size_.y);
+			std::int64_t z0 = coord(lo.z, cell_size_.z), z1 = coord(hi.z, cell_size_.z);
+
+			for (auto x = x0; x <= x1; x++)
+				for (auto y = y0; y <= y1; y++)
+					for (auto z = z0; z <= z1; z++)
+						if (auto *cell = find(pack(x, y, z)))
+							for (value_type elt : *cell)
+								f(elt);
+		}
 
-			return { cells.begin(), cells.end() };
+		//Invokes f(element) for every element in the cell of the given position or its immediate neighbours
+		template <typename F>
+		void for_each_near(Vector3 v, const F &f) const
+		{
+			for_each_in(v - cell_size_, v + cell_size_, f);
 		}
 
-		//Removes all elements from this grid
+		//Removes all elements and cells from this grid
 		void clear()
 		{
-			for (auto &v : grid_)
-				v.second.clear();
+			std::fill(slots_.begin(), slots_.end(), Slot());
+			cells_.clear();
 		}
 
-		//Gets the 3-tuple grid index of the given position vector
+		//Gets the grid index of the cell containing the given position vector
 		index_type index(Vector3 v) const
 		{
-			int x = static_cast<int>(v.x / cell_size_.x);
-			int y = static_cast<int>(v.y / cell_size_.y);
-			int z = static_cast<int>(v.z / cell_size_.z);
-
-			if (v.x < 0.0) x--;
-			if (v.y < 0.0) y--;
-			if (v.z < 0.0) z--;
-
-			return { x,y,z };
+			return pack(coord(v.x, cell_size_.x), coord(v.y, cell_size_.y), coord(v.z, cell_size_.z));
 		}
 	};
 }
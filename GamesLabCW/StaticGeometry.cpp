@@ -0,0 +1,55 @@
+/**
+ * StaticGeometry.cpp
+ * Implements the StaticGeometry class, which indexes the solid
+ * planes of a level so bodies only test those near them.
+ */
+
+#include "StaticGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+game::StaticGeometry::StaticGeometry(double cell_size) :
+	grid_({ cell_size, cell_size, cell_size })
+{
+}
+
+void game::StaticGeometry::clear()
+{
+	planes_.clear();
+	unbounded_.clear();
+	grid_.clear();
+	stale_ = false;
+}
+
+std::uint32_t game::StaticGeometry::add(const Plane &plane)
+{
+	auto i = static_cast<std::uint32_t>(planes_.size());
+	planes_.push_back(plane);
+
+	//A plane reaches at most its size from its centre line along any axis
+	if (std::isfinite(plane.size))
+	{
+		Vector3 extent = {
+			plane.size + std::abs(plane.span.x),
+			plane.size + std::abs(plane.span.y),
+			plane.size + std::abs(plane.span.z) };
+		grid_.insert_in(plane.position - extent, plane.position + extent, i);
+	}
+	else
+		unbounded_.push_back(i);
+
+	return i;
+}
+
+void game::StaticGeometry::query(Vector3 lo, Vector3 hi, std::vector<std::uint32_t> &out) const
+{
+	size_t first = out.size();
+
+	out.insert(out.end(), unbounded_.begin(), unbounded_.end());
+	grid_.for_each_in(lo, hi, [&out](std::uint32_t i) { out.push_back(i); });
+
+	//Planes spanning several cells are seen once from each
+	std::sort(out.begin() + first, out.end());
+	out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
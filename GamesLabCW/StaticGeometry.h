@@ -0,0 +1,67 @@
+/**
+ * StaticGeometry.h
+ * Declares the StaticGeometry class, which indexes the solid
+ * planes of a level so bodies only test those near them.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "SpatialGrid.h"
+
+namespace game
+{
+	class StaticGeometry
+	{
+	public:
+		//A solid plane, as given by a SolidPlaneComponent
+		struct Plane
+		{
+			Vector3 normal;
+			Vector3 position;
+			double size;
+			Vector3 span;
+		};
+
+	private:
+		//Every plane, in the order added
+		std::vector<Plane> planes_;
+
+		//Planes of unbounded size, which every body tests
+		std::vector<std::uint32_t> unbounded_;
+
+		//Bounded planes by every cell their extent overlaps
+		SpatialGrid<std::uint32_t> grid_;
+
+		//Do the planes need adding again?
+		bool stale_ = true;
+
+	public:
+		//Creates an empty index with cells of the given size
+		explicit StaticGeometry(double cell_size = 32.0);
+
+		//Whether the planes indexed are still those of the level
+		bool valid() const { return !stale_; }
+
+		//Marks the index as out of date, e.g. once planes are created or destroyed
+		void invalidate() { stale_ = true; }
+
+		//Removes every plane, leaving the index valid and empty
+		void clear();
+
+		//Adds a plane, returning its index
+		std::uint32_t add(const Plane &plane);
+
+		//Gets a plane by index
+		const Plane &plane(std::uint32_t i) const { return planes_[i]; }
+
+		//Gets the number of planes
+		size_t size() const { return planes_.size(); }
+
+		//Appends the index of each plane whose extent may overlap the box between the given corners
+		//to out, once and in the order added, so responses apply as they would over every plane
+		void query(Vector3 lo, Vector3 hi, std::vector<std::uint32_t> &out) const;
+	};
+}
@@ -0,0 +1,170 @@
+/**
+ * SweepAndPrune.cpp
+ * Implements the SweepAndPrune class, which finds potential
+ * collisions by keeping bounding boxes sorted along an axis.
+ */
+
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+namespace
+{
+	//Position of an entity not in the broadphase
+	constexpr size_t ABSENT = ~size_t(0);
+}
+
+void game::SweepAndPrune::update(Entity e, Vector3 position, double radius, LayerMask layer, LayerMask mask)
+{
+	size_t i = slot(e);
+	if (i >= where_.size())
+		where_.resize(i + 1, ABSENT);
+
+	Vector3 extent = { radius, radius, radius };
+	if (where_[i] == ABSENT)
+	{
+		where_[i] = boxes_.size();
+		boxes_.push_back({ position - extent, position + extent, e, layer, mask, false });
+		dirty_ = true;
+	}
+	else
+	{
+		//Only a change of lower bound along the axis can break the sort order
+		Box &b = boxes_[where_[i]];
+		if (b.lo.x != position.x - radius)
+			dirty_ = true;
+
+		b.lo = position - extent;
+		b.hi = position + extent;
+		b.layer = layer;
+		b.mask = mask;
+	}
+
+	max_width_ = std::max(max_width_, 2 * radius);
+}
+
+void game::SweepAndPrune::remove(Entity e)
+{
+	size_t i = slot(e);
+	if (i >= where_.size() || where_[i] == ABSENT) return;
+
+	//Left in place until the next sort, so other positions stay valid
+	boxes_[where_[i]].removed = true;
+	where_[i] = ABSENT;
+	removed_ = dirty_ = true;
+}
+
+void game::SweepAndPrune::clear()
+{
+	boxes_.clear();
+	where_.clear();
+	max_width_ = 0;
+	dirty_ = removed_ = false;
+
+	statics_.clear();
+	static_max_width_ = 0;
+}
+
+void game::SweepAndPrune::build_static(const std::vector<StaticBody> &bodies)
+{
+	statics_.clear();
+	static_max_width_ = 0;
+
+	for (auto &b : bodies)
+	{
+		Vector3 extent = { b.radius, b.radius, b.radius };
+		statics_.push_back({ b.position - extent, b.position + extent, b.entity, b.layer, b.mask, false });
+		static_max_width_ = std::max(static_max_width_, 2 * b.radius);
+	}
+
+	//Sorted once, as static boxes never move
+	std::sort(statics_.begin(), statics_.end(), [](const Box &a, const Box &b) { return a.lo.x < b.lo.x; });
+}
+
+void game::SweepAndPrune::sort()
+{
+	if (removed_)
+		boxes_.erase(std::remove_if(boxes_.begin(), boxes_.end(), [](const Box &b) { return b.removed; }), boxes_.end());
+
+	for (size_t i = 1; i < boxes_.size(); i++)
+	{
+		Box b = boxes_[i];
+		size_t j = i;
+		for (; j > 0 && boxes_[j - 1].lo.x > b.lo.x; j--)
+			boxes_[j] = boxes_[j - 1];
+		boxes_[j] = b;
+	}
+
+	max_width_ = 0;
+	for (size_t i = 0; i < boxes_.size(); i++)
+	{
+		where_[slot(boxes_[i].entity)] = i;
+		max_width_ = std::max(max_width_, boxes_[i].hi.x - boxes_[i].lo.x);
+	}
+
+	dirty_ = removed_ = false;
+}
+
+void game::SweepAndPrune::refresh()
+{
+	if (dirty_)
+		sort();
+}
+
+void game::SweepAndPrune::query_box(Vector3 lo, Vector3 hi, std::vector<Entity> &out, LayerMask mask) const
+{
+	auto overlaps = [&](const Box &b) {
+		return !b.removed && (b.layer & mask) &&
+			b.lo.x <= hi.x && b.hi.x >= lo.x &&
+			b.lo.y <= hi.y && b.hi.y >= lo.y &&
+			b.lo.z <= hi.z && b.hi.z >= lo.z;
+	};
+
+	//Out of order since the last refresh, so every moving box must be checked
+	if (dirty_)
+	{
+		for (auto &b : boxes_)
+			if (overlaps(b))
+				out.push_back(b.entity);
+	}
+	else
+	{
+		//No box starting further back than the widest box can reach the query
+		auto it = std::lower_bound(boxes_.begin(), boxes_.end(), lo.x - max_width_,
+			[](const Box &b, double x) { return b.lo.x < x; });
+
+		for (; it != boxes_.end() && it->lo.x <= hi.x; ++it)
+			if (overlaps(*it))
+				out.push_back(it->entity);
+	}
+
+	for_each_static_in(lo, hi, [&](const Box &b) {
+		if (b.layer & mask)
+			out.push_back(b.entity);
+	});
+}
+
+void game::SweepAndPrune::pairs(std::vector<EntityPair> &out)
+{
+	refresh();
+
+	//Each box pairs with the later boxes starting within it, so every pair is found once
+	for (size_t i = 0; i < boxes_.size(); i++)
+	{
+		const Box &a = boxes_[i];
+		for (size_t j = i + 1; j < boxes_.size() && boxes_[j].lo.x <= a.hi.x; j++)
+		{
+			const Box &b = boxes_[j];
+			if (layers_collide(a.layer, a.mask, b.layer, b.mask) &&
+				a.lo.y <= b.hi.y && a.hi.y >= b.lo.y &&
+				a.lo.z <= b.hi.z && a.hi.z >= b.lo.z)
+				out.push_back(ordered_pair(a.entity, b.entity));
+		}
+
+		//Static boxes only pair with moving ones, so are seen from this side alone
+		for_each_static_in(a.lo, a.hi, [&](const Box &b) {
+			if (layers_collide(a.layer, a.mask, b.layer, b.mask))
+				out.push_back(ordered_pair(a.entity, b.entity));
+		});
+	}
+}
@@ -0,0 +1,79 @@
+/**
+ * SweepAndPrune.h
+ * Declares the SweepAndPrune class, which finds potential
+ * collisions by keeping bounding boxes sorted along an axis.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "Broadphase.h"
+
+namespace game
+{
+	class SweepAndPrune : public Broadphase
+	{
+	private:
+		//Axis-aligned bounds of an entity
+		struct Box
+		{
+			Vector3 lo;
+			Vector3 hi;
+			Entity entity;
+			LayerMask layer;
+			LayerMask mask;
+			bool removed;
+		};
+
+		//Boxes of moving entities, sorted by their lower bound along the x axis when not dirty
+		std::vector<Box> boxes_;
+
+		//Position in boxes_ of each entity, by entity index
+		std::vector<size_t> where_;
+
+		//Widest box along the x axis, bounding how far back an overlapping box may start
+		double max_width_ = 0;
+
+		//Have boxes moved, arrived or left since they were last sorted?
+		bool dirty_ = false;
+
+		//Whether any boxes were removed since they were last sorted
+		bool removed_ = false;
+
+		//Boxes of static entities, sorted by their lower bound along the x axis
+		std::vector<Box> statics_;
+
+		//Widest static box along the x axis
+		double static_max_width_ = 0;
+
+		//Restores the sort order. Boxes move little between ticks, so insertion sort is near linear
+		void sort();
+
+		//Invokes f(box) for every static box overlapping the box between the given corners
+		template <typename F>
+		void for_each_static_in(Vector3 lo, Vector3 hi, const F &f) const
+		{
+			auto it = std::lower_bound(statics_.begin(), statics_.end(), lo.x - static_max_width_,
+				[](const Box &b, double x) { return b.lo.x < x; });
+
+			for (; it != statics_.end() && it->lo.x <= hi.x; ++it)
+				if (it->hi.x >= lo.x &&
+					it->lo.y <= hi.y && it->hi.y >= lo.y &&
+					it->lo.z <= hi.z && it->hi.z >= lo.z)
+					f(*it);
+		}
+
+	protected:
+		void build_static(const std::vector<StaticBody> &bodies) override;
+
+	public:
+		void update(Entity e, Vector3 position, double radius, LayerMask layer, LayerMask mask) override;
+		void remove(Entity e) override;
+		void clear() override;
+		void refresh() override;
+		void query_box(Vector3 lo, Vector3 hi, std::vector<Entity> &out, LayerMask mask) const override;
+		void pairs(std::vector<EntityPair> &out) override;
+		const char *name() const override { return "sweep and prune"; }
+	};
+}
@@ -17,7 +17,7 @@ using namespace std;
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-std::vector<game::systems::SystemInvoker> game::systems::system_invokers;
+std::vector<game::systems::SystemRecord> game::systems::system_invokers;
 
 namespace game::systems
 {
@@ -26,52 +26,24 @@ namespace game::systems
 	{
 		//ESC quits the game
 		if (input::is_pressed(input::KEY_ESCAPE))
-			events::dispatcher.trigger<events::QuitGame>();
+			events::dispatcher.enqueue<events::QuitGame>();
 
 		//F11 toggles fullscreen
 		if (input::is_pressed(input::KEY_F11))
-			events::dispatcher.trigger<events::ToggleFullscreen>();
+			events::dispatcher.enqueue<events::ToggleFullscreen>();
 	};
-	SYSTEM(GameStateSystem, GameStateComponent);
-
-	auto OverlaySystem = [](SceneInfo info, auto entity, OverlayComponent &o)
-	{
-		info.scene.destroy(entity);
-	};
-	SYSTEM(OverlaySystem, OverlayComponent);
+	SYSTEM(GameStateSystem, GameStateComponent, Writes<resource::Events>);
 
 	const int MAX_MANA = 3;
 	const int MIN_HEALTH = 1;
 	const double Y_AXIS_CLAMP = 85.0;
 	const double MOUSE_SENSITIVITY = 5.0;
-	const double START_OVERLAY_MAX = 7.0;
-	double startOverlayTimer = 0.0;
 	//First-person control by the player
 	auto FirstPersonControllerSystem = [](SceneInfo info, auto entity, FirstPersonControllerComponent &f, TransformComponent &t, KinematicComponent &k, ProjectileComponent &bc, CollisionComponent &c, StatsComponent &s)
 	{
-		// Game completion states
-		if (s.health < MIN_HEALTH)
-		{
-			OverlayComponent i_lose;
-			i_lose.texture_file = "models/UI/lose.png";
-			info.scene.instantiate("Overlay", i_lose);
-			return;
-		}
-		if (s.gameComplete)
-		{
-			OverlayComponent i_win;
-			i_win.texture_file = "models/UI/win.png";
-			info.scene.instantiate("Overlay", i_win);
+		// Game completion states (shown by the HUD)
+		if (s.health < MIN_HEALTH || s.gameComplete)
 			return;
-		}
-
-		startOverlayTimer += info.dt;
-		if (startOverlayTimer < START_OVERLAY_MAX)
-		{
-			OverlayComponent i_start;
-			i_start.texture_file = "models/UI/start.png";
-			info.scene.instantiate("Overlay", i_start);
-		}
 
 		s.mana += info.dt * 2;
 
@@ -113,51 +85,6 @@ namespace game::systems
 			events::dispatcher.enqueue<events::FireBullet>(info.scene, bc.model_file, t.position, t.rotation, bc.vs, bc.fs, bc.particle_file, c.radius, true);
 		}
 
-		OverlayComponent i_hp; 
-		OverlayComponent i_mp;
-		OverlayComponent i_ch;
-		
-		switch (s.health)
-		{
-		case 1:
-			i_hp.texture_file = "models/UI/hearts-1.png";
-			break;
-		case 2:
-			i_hp.texture_file = "models/UI/hearts-2.png";
-			break;
-		case 3:
-			i_hp.texture_file = "models/UI/hearts-3.png";
-			break;
-		default:
-			i_hp.texture_file = "models/UI/hearts-3.png";
-			break;
-		}
-
-		switch (int(s.mana))
-		{
-		case 0:
-			i_mp.texture_file = "models/UI/mana-0.png";
-			break;
-		case 1:
-			i_mp.texture_file = "models/UI/mana-1.png";
-			break;
-		case 2:
-			i_mp.texture_file = "models/UI/mana-2.png";
-			break;
-		case 3:
-			i_mp.texture_file = "models/UI/mana-3.png";
-			break;
-		default:
-			i_mp.texture_file = "models/UI/mana-3.png";
-			break;
-		}
-
-		i_ch.texture_file = "models/UI/crosshair.png";
-
-		info.scene.instantiate("Overlay", i_hp);
-		info.scene.instantiate("Overlay", i_mp);
-		info.scene.instantiate("Overlay", i_ch);
-
 		// DEBUGGING FOR DEMO - increase key point
 		if (input::is_pressed(input::KEY_F1))
 		{
@@ -165,18 +92,18 @@ namespace game::systems
 
 			if (s.keyCount == 6)
 			{
-				info.scene.instantiate("PointLight", PointLightComponent{ {255, 215, 0}, 10.0, { -30, 12, 0 } });
+				info.commands().instantiate("PointLight", PointLightComponent{ {255, 215, 0}, 10.0, { -30, 12, 0 } });
 			}
 		}
 	};
-	SYSTEM(FirstPersonControllerSystem, FirstPersonControllerComponent, TransformComponent, KinematicComponent, ProjectileComponent, CollisionComponent, StatsComponent);
+	SYSTEM(FirstPersonControllerSystem, FirstPersonControllerComponent, TransformComponent, KinematicComponent, ProjectileComponent, CollisionComponent, StatsComponent, Writes<resource::Events>);
 
 	//EXAMPLE Moveable sphere to demo collisions
 	auto MoveSphereSystem = [](auto info, auto entity, auto&, TransformComponent& t)
 	{
 		t.position.z += 2.0 * info.dt * (input::is_held(input::KEY_X) - input::is_held(input::KEY_Z));
 	};
-	SYSTEM(MoveSphereSystem, MoveSphere, TransformComponent);
+	SYSTEM_PARALLEL(MoveSphereSystem, const MoveSphere, TransformComponent);
 
 	//Basic kinematic system of calculus of motion
 	auto KinematicSystem = [](auto info, auto entity, TransformComponent &t, KinematicComponent &k)
@@ -196,138 +123,233 @@ namespace game::systems
 		//Integrate angular velocity
 		t.rotation += k.angular_velocity * info.dt;
 	};
-	SYSTEM(KinematicSystem, TransformComponent, KinematicComponent);
+	SYSTEM_PARALLEL(KinematicSystem, TransformComponent, KinematicComponent);
 
-	//Updates the spatial partitioning grid
-	auto SpatialGridSystem = [](SceneInfo info, auto entity, TransformComponent &t, CollisionComponent &)
+	//Indexes the level's solid planes again whenever they have changed
+	auto StaticGeometrySystem = [](SceneInfo info)
 	{
-		auto i = info.scene.spatial_grid.update(t.position, entity, t.last_index);
-		t.last_index = i;
+		StaticGeometry &geometry = info.scene.static_geometry();
+		if (geometry.valid()) return;
+
+		geometry.clear();
+		info.registry.view<const SolidPlaneComponent>().each([&](auto, const SolidPlaneComponent &sp) {
+			geometry.add({ sp.normal, sp.position, sp.size, sp.span });
+		});
 	};
-	SYSTEM(SpatialGridSystem, TransformComponent, CollisionComponent);
+	SYSTEM_ONCE(StaticGeometrySystem, Reads<SolidPlaneComponent>, Writes<resource::StaticGeometry>);
 
-	//Detects collisions, updating pools and logging events
-	auto CollisionSystem = [](SceneInfo info, auto entity, CollisionComponent& c1, TransformComponent& t1)
+	//Stops bullets at the first wall along the path they moved this tick, so fast ones can't pass through.
+	//Bullets aren't solid, so SolidPlaneSystem never tests them
+	auto BulletWallSystem = [](SceneInfo info, auto entity, TransformComponent &t, BulletComponent &b)
 	{
-		//Get set of all nearby entities
-		auto [begin, end] = info.scene.spatial_grid.get_cells_near(t1.position);
+		Vector3 moved = t.position - t.position_old;
+		double distance = moved.abs();
+		if (!b.draw || distance == 0) return;
 
-		//Test against potentially colliding entities
-		for (auto it = begin; it != end; ++it)
+		RayHit hit;
+		if (info.scene.raycast({ t.position_old, moved / distance, distance, entity }, layers::Wall, hit))
 		{
-			Entity other = *it;
-
-			if (!info.registry.valid(entity) || !info.registry.valid(other)) continue;
-
-			//Ignore self
-			if (other == entity) continue;
+			t.position = hit.point;
+			b.draw = false;
+		}
+	};
+	SYSTEM(BulletWallSystem, TransformComponent, BulletComponent, Reads<CollisionComponent, resource::Broadphase, resource::StaticGeometry>);
 
-			//Ignore if not collidable
-			if (!info.registry.has<CollisionComponent>(other)) continue;
+	//Gets the radius of the largest sphere an entity may collide through
+	double bounding_radius(const entt::registry<> &reg, Entity e, const CollisionComponent &c)
+	{
+		double r = c.radius;
+		if (reg.has<DetectionComponent>(e)) r = std::max(r, reg.get<DetectionComponent>(e).c.radius);
+		if (reg.has<HitboxComponent>(e)) r = std::max(r, reg.get<HitboxComponent>(e).c.radius);
+		return r;
+	}
+
+	//Indexes colliders without kinematics, which never move, again whenever they have changed
+	auto StaticCollidersSystem = [](SceneInfo info)
+	{
+		Broadphase &bp = info.scene.broadphase();
+		if (bp.static_valid()) return;
 
-			auto& [c2, t2] = info.registry.get<CollisionComponent, TransformComponent>(other);
+		thread_local std::vector<Broadphase::StaticBody> bodies;
+		bodies.clear();
+		info.registry.view<const TransformComponent, const CollisionComponent>().each([&](auto e, auto &t, auto &c) {
+			if (!info.registry.has<KinematicComponent>(e))
+				bodies.push_back({ e, t.position, bounding_radius(info.registry, e, c), c.layer, c.mask });
+		});
 
-			bool detect = false;
-			bool hitbox = false;
-			bool isBullet = false;
-			if (info.registry.has<DetectionComponent>(other) && info.registry.has<FirstPersonControllerComponent>(entity))
-			{
-				DetectionComponent& d = info.registry.get<DetectionComponent>(other);
-				c2 = d.c;
-				t2 = info.registry.get<TransformComponent>(other);
-			}
+		bp.set_static(bodies);
+	};
+	SYSTEM_ONCE(StaticCollidersSystem, Reads<TransformComponent, CollisionComponent, KinematicComponent, DetectionComponent, HitboxComponent>,
+		Writes<resource::Broadphase>);
 
-			//if (!(info.registry.has<DetectionComponent>(other) && info.registry.has<BulletComponent>(entity)))
-			//{
-			//	Entity t = other;
-			//	other = entity;
-			//	entity = t;
-			//}
+	//Updates the broadphase with every moving collider's bounds, covering the whole path of those swept.
+	//The broadphase only re-buckets an entity once its cell changes
+	auto BroadphaseSystem = [](SceneInfo info, auto entity, const TransformComponent &t, const CollisionComponent &c, const KinematicComponent &)
+	{
+		double radius = bounding_radius(info.registry, entity, c);
+		if (c.continuous)
+		{
+			Vector3 moved = t.position - t.position_old;
+			info.scene.broadphase().update(entity, t.position_old + moved / 2.0, radius + moved.abs() / 2, c.layer, c.mask);
+		}
+		else
+			info.scene.broadphase().update(entity, t.position, radius, c.layer, c.mask);
+	};
+	SYSTEM(BroadphaseSystem, const TransformComponent, const CollisionComponent, const KinematicComponent,
+		Reads<DetectionComponent, HitboxComponent>, Writes<resource::Broadphase>);
 
-			if (info.registry.has<DetectionComponent>(other) && info.registry.has<BulletComponent>(entity))
-			{
-				isBullet = true;
-				AIComponent &ai = info.registry.get<AIComponent>(other);
-				BulletComponent& bc = info.registry.get<BulletComponent>(entity);
+	//A collider's spheres and role, gathered once per tick so pairs needn't query the registry
+	struct Collider
+	{
+		bool present = false;
+		Vector3 position;
+		Vector3 position_old;
+		double radius;
+		double detection;
+		double hitbox;
+		bool player;
+		bool bullet;
+		bool players_bullet;
+		bool detects;
+		bool continuous;
+	};
 
-				if (ai.dodgeCooldown > ai.dodgeMax && bc.isPlayers)
-				{
-					DetectionComponent& d = info.registry.get<DetectionComponent>(other);
-					c2 = d.c; 
-					detect = true;
-					ai.dodgeBullet = true;
-				}
+	//Gets the radius of a collider's sphere against another: enemies detect players
+	//through their detection sphere, and are hit by bullets through their hitbox
+	double contact_radius(const Collider &c, const Collider &other)
+	{
+		if (c.detects && other.player) return c.detection;
+		if (c.detects && other.bullet) return c.hitbox;
+		return c.radius;
+	}
 
+	//Detects collisions between pairs of entities, logging events as they enter and leave contact
+	auto CollisionSystem = [](SceneInfo info)
+	{
+		auto &reg = info.registry;
+		Narrowphase &narrow = info.scene.narrowphase;
+
+		//Gather every collider by entity index
+		thread_local std::vector<Collider> colliders;
+		colliders.assign(colliders.size(), Collider());
+		reg.view<CollisionComponent, TransformComponent>().each([&](auto e, auto &c, auto &t) {
+			size_t i = e & entt::entt_traits<Entity>::entity_mask;
+			if (i >= colliders.size())
+				colliders.resize(i + 1);
+
+			Collider &o = colliders[i];
+			o.present = true;
+			o.position = t.position;
+			o.position_old = t.position_old;
+			o.radius = c.radius;
+			o.detects = reg.has<DetectionComponent>(e);
+			o.detection = o.detects ? reg.get<DetectionComponent>(e).c.radius : c.radius;
+			o.hitbox = reg.has<HitboxComponent>(e) ? reg.get<HitboxComponent>(e).c.radius : c.radius;
+			o.player = reg.has<FirstPersonControllerComponent>(e);
+			o.bullet = reg.has<BulletComponent>(e);
+			o.players_bullet = o.bullet && reg.get<BulletComponent>(e).isPlayers;
+			o.continuous = c.continuous;
+		});
+		auto collider = [&](Entity e) -> const Collider* {
+			size_t i = e & entt::entt_traits<Entity>::entity_mask;
+			return reg.valid(e) && i < colliders.size() && colliders[i].present ? &colliders[i] : nullptr;
+		};
 
-				{
-					HitboxComponent& h = info.registry.get<HitboxComponent>(other);
-					c2 = h.c;
-					hitbox = true;
-					
-				}
-				
-				
-				t2 = info.registry.get<TransformComponent>(other);
-					
-			}
+		//Candidate pairs from the broadphase. Contacts which aren't among them leave on their own,
+		//as nothing refreshes them
+		thread_local std::vector<EntityPair> candidates;
+		candidates.clear();
+		info.scene.broadphase().pairs(candidates);
 
-			//Test if currently colliding (distance between centres less than sum of radii)
-			double d2 = sqrt(std::pow(t2.position.x - t1.position.x, 2) +
-				std::pow(t2.position.y - t1.position.y, 2) +
-				std::pow(t2.position.z - t1.position.z, 2));
+		narrow.begin();
+		for (auto &pair : candidates)
+		{
+			auto *a = collider(pair.first);
+			auto *b = collider(pair.second);
+			if (!a || !b) continue;
 
-			double sumRad = c1.radius + c2.radius;
-			bool currently_colliding = d2 < sumRad;
+			//Enemies ready to dodge notice the player's bullets entering their detection sphere
+			for (auto [bullet, enemy, e] : { std::tuple(a, b, pair.second), std::tuple(b, a, pair.first) })
+			{
+				if (!bullet->players_bullet || !enemy->detects || !reg.has<AIComponent>(e)) continue;
 
+				Vector3 d = enemy->position - bullet->position;
+				double r = enemy->detection + bullet->radius;
+				AIComponent &ai = reg.get<AIComponent>(e);
+				if (ai.dodgeCooldown > ai.dodgeMax && d.x * d.x + d.y * d.y + d.z * d.z < r * r)
+					ai.dodgeBullet = true;
+			}
 
+			double radius = contact_radius(*a, *b) + contact_radius(*b, *a);
+			if (a->continuous || b->continuous)
+				narrow.add_swept(pair, a->position_old, a->position, b->position_old, b->position, radius);
+			else
+				narrow.add(pair, a->position, b->position, radius);
+		}
+		narrow.finish();
 
-			bool was_colliding = utility::contains(c1.colliding, other);
+		//Events name the detecting entity second, as responses expect
+		auto oriented = [&](EntityPair pair) {
+			auto *a = collider(pair.first);
+			return a && a->detects ? EntityPair{ pair.second, pair.first } : pair;
+		};
 
-			//Log entering of collision
-			if (currently_colliding && !was_colliding)
-			{
-				c1.colliding.insert(other);
-				c2.colliding.insert(entity);
-				if (info.registry.has<AIComponent>(other))
-				{
-					if (!hitbox && !detect)
-					{
-						cout << "fart" << endl;
-					}
-					AIComponent &enterAI = info.registry.get<AIComponent>(other);
-					enterAI.hitBox = hitbox;
-					//enterAI.dodgeBullet = detect;
-				}
+		for (size_t i = 0; i < narrow.enter.size(); i++)
+		{
+			auto [a, b] = oriented(narrow.enter[i]);
 
-				events::dispatcher.enqueue<events::EnterCollision>(info, entity, other);
-			}
+			//Tell enemies whether it was their hitbox which was entered
+			if (reg.has<AIComponent>(b))
+				reg.get<AIComponent>(b).hitBox = collider(a)->bullet && collider(b)->detects;
 
-			//Log leaving of collision
-			if (!currently_colliding && was_colliding)
-			{
-				c1.colliding.erase(other);
-				c2.colliding.erase(entity);
+			events::dispatcher.enqueue<events::EnterCollision>(info, a, b, narrow.enter_time[i]);
+		}
 
-				events::dispatcher.enqueue<events::LeaveCollision>(info, entity, other);
-			}
+		for (auto pair : narrow.leave)
+		{
+			auto [a, b] = oriented(pair);
+			events::dispatcher.enqueue<events::LeaveCollision>(info, a, b);
 		}
 	};
-	SYSTEM(CollisionSystem, CollisionComponent, TransformComponent);
+	SYSTEM_ONCE(CollisionSystem,
+		Reads<CollisionComponent, TransformComponent, DetectionComponent, HitboxComponent, FirstPersonControllerComponent, BulletComponent>,
+		Writes<AIComponent, resource::Broadphase, resource::Contacts, resource::Events>);
 
 	//Makes a camera follow its target
-	auto MoveCameraSystem = [](SceneInfo info, auto entity, CameraComponent& c)
+	auto MoveCameraSystem = [](ParallelInfo info, auto entity, CameraComponent& c)
 	{
 		if (info.registry.valid(c.follow))
 		{
-			TransformComponent& t = info.scene.get<TransformComponent>(c.follow);
+			const TransformComponent& t = info.registry.get<TransformComponent>(c.follow);
 			c.position = t.position;
 			c.orientation = { t.rotation.x, t.rotation.y };
 		}
 	};
-	SYSTEM(MoveCameraSystem, CameraComponent);
+	SYSTEM_PARALLEL(MoveCameraSystem, CameraComponent, Reads<TransformComponent>);
+
+	//Runs after MoveCameraSystem so it shares a stage with collision detection
+	auto ParticleSystem = [](auto info, auto entity, const ParticleComponent &p, const ColourComponent &c, const TransformComponent &t, const KinematicComponent &k)
+	{
+		Vector3 randomPosition = Vector3(
+			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z,
+			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z,
+			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z);
+
+		Vector3 randomVelocity = Vector3(
+			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z,
+			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z,
+			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z);
+
+		Vector3 randomColor = Vector3(
+			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.x,
+			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.y,
+			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.z);
+
+		renderer::update_particle(info.dt, p.texture_file, p.respawn_count, randomPosition, randomVelocity, randomColor);
+	};
+	SYSTEM(ParticleSystem, const ParticleComponent, const ColourComponent, const TransformComponent, const KinematicComponent, Writes<resource::Renderer>);
 
 	//Animation system
-	const float ANIMATION_DELAY = 0.05;
 	auto AnimationSystem = [](auto info, auto entity, auto& m, auto& ai)
 	{
 		if (!m.isAnimated)
@@ -337,29 +359,22 @@ namespace game::systems
 
 		ai.t += info.dt;
 
-		if (ai.timeSinceLastUpdate < ANIMATION_DELAY)
-		{
-			ai.timeSinceLastUpdate += info.dt;
-			return;
-		}
-
-		ai.timeSinceLastUpdate = 0;
-
 		renderer::animate_model(ai.t, m.model_file);
 	};
-	SYSTEM(AnimationSystem, ModelComponent, AIComponent);
+	SYSTEM(AnimationSystem, const ModelComponent, AIComponent, Writes<resource::Renderer>, Rate<20>);
 
 	const int MAX_WAITING_TIME = 7;
 	const int MAX_MOVING_TIME = 4;
 	const double MAX_DODGE_TIME = 0.5;
 	const int WALK_SPEED = 300;
 	const int DODGE_SPEED = 2000;
+	const double AI_MOVE_STEP = 1.0 / GAME_RATE; //Speeds are tuned per game tick, whatever rate the AI runs at
 	const int ATTACK_ANIMATION_DURATION = 1;
 	const int HIT_ANIMATION_DURATION = 0.6;
 	auto AISystem = [](SceneInfo info, Entity entity, ModelComponent &m, TransformComponent &t, AIComponent &a, ProjectileComponent &bc, StatsComponent &s, DetectionComponent &d, HitboxComponent &h, KinematicComponent &k)
 	{
 		//Get reference to camera
-		CameraComponent &c = info.scene.get<CameraComponent>(d.camera);
+		const CameraComponent &c = info.registry.get<CameraComponent>(d.camera);
 		s.mana += info.dt;
 		a.animationTime += info.dt;
 		//if (k.solid == false)
@@ -369,7 +384,7 @@ namespace game::systems
 
 		if (s.health < 1)
 		{
-			info.scene.destroy(entity);
+			info.commands().destroy(entity);
 		}
 		else if (a.isHit)
 		{
@@ -391,7 +406,7 @@ namespace game::systems
 					auto direction = Vector2(fmod(t.rotation.y + r, 360), 0).direction_hv().ToGLM();
 					Vector3 move = glm::normalize(direction);
 					a.moving = 0;
-					k.move_velocity = move * WALK_SPEED * info.dt;
+					k.move_velocity = move * WALK_SPEED * AI_MOVE_STEP;
 					t.rotation.y = Vector2(fmod(t.rotation.y + r, 360), 0).abs();
 				}
 				else if (a.moving > MAX_MOVING_TIME)
@@ -410,7 +425,6 @@ namespace game::systems
 			else if (a.state == a.Dodge)
 			{
 				m.model_file = a.walk_file;
-				cout << (a.dodgeCooldown > a.dodgeMax) << endl;
 
 				if (a.dodgeCooldown > a.dodgeMax)
 				{
@@ -422,11 +436,11 @@ namespace game::systems
 					int r = rand() % 2;
 					if (r == 1)
 					{
-						k.move_velocity = move * DODGE_SPEED * info.dt;
+						k.move_velocity = move * DODGE_SPEED * AI_MOVE_STEP;
 					}
 					else
 					{
-						k.move_velocity = move * DODGE_SPEED * info.dt * -1;
+						k.move_velocity = move * DODGE_SPEED * AI_MOVE_STEP * -1;
 					}
 				}
 				a.state = a.Look;
@@ -454,7 +468,13 @@ namespace game::systems
 				else
 					t.rotation.y = (glm::degrees(acos(cosinedegreesToRotate)));
 
-				if (s.mana > MAX_MANA)
+				//Only fire at a player in sight, not through the maze's walls
+				Vector3 to_camera = c.position - t.position;
+				double distance = to_camera.abs();
+				RayHit wall;
+				bool in_sight = distance > 0 && !info.scene.raycast({ t.position, to_camera / distance, distance, entity }, layers::Wall, wall);
+
+				if (s.mana > MAX_MANA && in_sight)
 				{
 					s.mana = 0;
 					Vector3 rotation = { fmod(t.rotation.y,360), 0, 0 };
@@ -472,28 +492,9 @@ namespace game::systems
 		
 		
 	};
-	SYSTEM(AISystem, ModelComponent, TransformComponent, AIComponent, ProjectileComponent, StatsComponent, DetectionComponent, HitboxComponent, KinematicComponent);
+	SYSTEM(AISystem, ModelComponent, TransformComponent, AIComponent, ProjectileComponent, StatsComponent, DetectionComponent, HitboxComponent, KinematicComponent,
+		Reads<CameraComponent, CollisionComponent, resource::Broadphase, resource::StaticGeometry>, Writes<resource::Events>, Rate<20>, Slices<4>, Budget<1000>);
 	
-	auto ParticleSystem = [](auto info, auto entity, ParticleComponent &p, ColourComponent &c, TransformComponent &t, KinematicComponent &k)
-	{
-		Vector3 randomPosition = Vector3(
-			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z,
-			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z,
-			((fmod(rand(), p.position_variation.x)) - p.position_variation.y) / p.position_variation.z);
-
-		Vector3 randomVelocity = Vector3(
-			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z,
-			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z,
-			((fmod(rand(), p.velocity_variation.x)) - p.velocity_variation.y) / p.velocity_variation.z);
-
-		Vector3 randomColor = Vector3(
-			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.x,
-			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.y,
-			(((fmod(rand(), p.color_variation.x)) - p.color_variation.y) / p.color_variation.z) * p.color_modifier.z);
-
-		renderer::update_particle(info.dt, p.texture_file, p.respawn_count, randomPosition, randomVelocity, randomColor);
-	};
-	SYSTEM(ParticleSystem, ParticleComponent, ColourComponent, TransformComponent, KinematicComponent);
 
 	const int BULLET_TIMEOUT = 5;
 	auto BulletSystem = [](auto info, auto entity, BulletComponent &b) {
@@ -501,14 +502,14 @@ namespace game::systems
 		b.timeAlive += info.dt;
 		if (!b.draw || b.timeAlive > BULLET_TIMEOUT)
 		{
-			info.scene.destroy(entity);
+			info.commands().destroy(entity);
 		}
 
 	};
 	SYSTEM(BulletSystem, BulletComponent);
 	
 	//Handles collision response for kinematic bodies against solid planes
-	auto SolidPlaneSystem = [](SceneInfo info, auto entity, TransformComponent &t, KinematicComponent &k, CollisionComponent &c)
+	auto SolidPlaneSystem = [](ParallelInfo info, auto entity, TransformComponent &t, KinematicComponent &k, const CollisionComponent &c)
 	{
 		//Scalar projection of a onto b
 		auto scalar_projection = [](glm::vec3 a, glm::vec3 b)
@@ -528,11 +529,26 @@ namespace game::systems
 		//Add movement speed
 		t.position += k.move_velocity * info.dt;
 
-		//Calculate collision response for every solid plane
+		//Calculate collision response for every solid plane near the path moved this tick
 		if (!NOCLIP && k.solid)
 		{
-			info.registry.view<SolidPlaneComponent>().each([&](auto entity, SolidPlaneComponent &sp)
+			const StaticGeometry &geometry = info.scene.static_geometry();
+
+			//A plane responds within its size of its centre, plus the depth of a crossing, which is
+			//at most twice the distance moved
+			Vector3 moved = t.position - t.position_old;
+			double reach = c.radius + 2 * moved.abs();
+			Vector3 extent = { reach, reach, reach };
+			Vector3 lo = { std::min(t.position.x, t.position_old.x), std::min(t.position.y, t.position_old.y), std::min(t.position.z, t.position_old.z) };
+			Vector3 hi = { std::max(t.position.x, t.position_old.x), std::max(t.position.y, t.position_old.y), std::max(t.position.z, t.position_old.z) };
+
+			thread_local std::vector<std::uint32_t> nearby;
+			nearby.clear();
+			geometry.query(lo - extent, hi + extent, nearby);
+
+			for (auto i : nearby)
 			{
+				const StaticGeometry::Plane &sp = geometry.plane(i);
 				Vector3 normal = sp.normal;
 				double pos = scalar_projection(sp.position, normal) + c.radius;
 
@@ -544,8 +560,12 @@ namespace game::systems
 					double depth = s2 - pos;
 					double fraction = (s1 - pos) / (s1 - s2);
 
-					//Absolute distance to plane centre
-					double dist = glm::length(glm::vec3(sp.position - t.position));
+					//Absolute distance to the nearest point of the plane's centre line
+					glm::vec3 centre = sp.position;
+					glm::vec3 span = sp.span;
+					if (glm::dot(span, span) > 0)
+						centre += span * glm::clamp(glm::dot(glm::vec3(t.position) - centre, span) / glm::dot(span, span), -1.0f, 1.0f);
+					double dist = glm::length(centre - glm::vec3(t.position));
 
 					//Squared distance perpendicular to plane
 					double d2 = dist * dist - depth * depth;
@@ -572,12 +592,12 @@ namespace game::systems
 						t.position += total_velocity * dt2;
 					}
 				}
-			});
+			}
 		}
 
 		//Reset acceleration again
 		k.acceleration = { 0, 0, 0 };
 	};
-	SYSTEM(SolidPlaneSystem, TransformComponent, KinematicComponent, CollisionComponent);
+	SYSTEM_PARALLEL(SolidPlaneSystem, TransformComponent, KinematicComponent, const CollisionComponent, Reads<resource::StaticGeometry>);
 }
 
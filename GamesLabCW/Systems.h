@@ -6,48 +6,372 @@
 
 #pragma once
 
-#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 #include <entt/entt.hpp>
 
 #include "Components.h"
+#include "CommandBuffer.h"
+#include "Jobs.h"
 
 namespace game::systems
 {
-	//Function representing a system, receiving dt, entity and arbitrary components
-	template <typename... Ts>
-	using SystemFunction = std::function<void(SceneInfo, entt::registry<>::entity_type, Ts&...)>;
+	//Numerical identifier of a component or resource type
+	using AccessType = entt::registry<>::component_type;
 
-	//Wrapped system function to be invoked by registry owner
-	using SystemInvoker = std::function<void(SceneInfo, entt::registry<>&)>;
+	//Declares component types a system reads through the registry, beyond its own view
+	template <typename... Ts>
+	struct Reads {};
 
-	//Wraps a system function
+	//Declares component types a system writes through the registry, beyond its own view
 	template <typename... Ts>
-	SystemInvoker system_invoker(const SystemFunction<Ts...> &f)
+	struct Writes {};
+
+	//Declares that a system must run alone on the main thread (immediate events, GL).
+	//Structural changes should be recorded through info.commands() instead
+	struct Exclusive {};
+
+	//Declares that a system runs at most Hz times per second, receiving the time since it last ran as dt
+	template <unsigned Hz>
+	struct Rate {};
+
+	//Declares that each run of a system visits only 1/N of its entities, round-robin,
+	//each receiving the dt of N runs. With a Budget, N is the most it may be split into
+	template <unsigned N>
+	struct Slices {};
+
+	//Declares a time budget for each run of a system in microseconds. Overruns are reported,
+	//and systems which also declare Slices are spread over more runs until they fit
+	template <unsigned Us>
+	struct Budget {};
+
+	//Base of shared engine state that systems may touch outside the registry
+	struct Resource {};
+
+	namespace resource
+	{
+		//The global event dispatcher (queueing events)
+		struct Events : Resource {};
+
+		//The scene's broadphase of potentially colliding entities
+		struct Broadphase : Resource {};
+
+		//The scene's record of entities in contact
+		struct Contacts : Resource {};
+
+		//The scene's index of solid planes
+		struct StaticGeometry : Resource {};
+
+		//The renderer's loaded models and particle effects
+		struct Renderer : Resource {};
+	}
+
+	//Entities handed to each job by parallel systems
+	constexpr size_t PARALLEL_GRAIN = 256;
+
+	//Information passed to parallel systems, which may only modify their own components
+	struct ParallelInfo
+	{
+		//Delta time (seconds since last update)
+		double dt;
+
+		//The registry in use, for reading components the system doesn't write
+		const entt::registry<> &registry;
+
+		//The current scene, for reading resources the system declares
+		const Scene &scene;
+	};
+
+	//Set of components and resources touched by a system
+	struct Access
 	{
-		return [f](SceneInfo info, entt::registry<> &reg)
+		std::vector<AccessType> reads;
+		std::vector<AccessType> writes;
+		bool exclusive = false;
+
+		//Whether running alongside a system with the other access could race
+		bool conflicts(const Access &other) const;
+	};
+
+	//How often a system runs and how long it may take
+	struct Timing
+	{
+		//Runs per second, or zero to run every tick
+		double rate = 0;
+
+		//Most shares its entities may be split into across runs
+		size_t slices = 1;
+
+		//Seconds each run may take, or zero if unlimited
+		double budget = 0;
+	};
+
+	//Runs a system over every matching entity in the registry
+	using SystemInvoker = void (*)(SceneInfo, entt::registry<>&);
+
+	//A registered system, as seen by the scheduler
+	struct SystemRecord
+	{
+		//Name of the system function
+		const char *name;
+
+		//Invokes the system over all matching entities
+		SystemInvoker invoke;
+
+		//Gets the components and resources touched by the system (type ids aren't ready during static registration)
+		Access (*access)();
+
+		//Creates the component pools touched by the system, so workers never need to
+		void (*prepare)(entt::registry<>&);
+
+		//Gets the declared rate, slicing and budget of the system
+		Timing (*timing)();
+	};
+
+	//Dictionary of registered systems, in registration order
+	extern std::vector<SystemRecord> system_invokers;
+
+	namespace detail
+	{
+		template <typename... Ts>
+		struct type_list {};
+
+		template <typename... Ls>
+		struct concat { using type = type_list<>; };
+
+		template <typename... As>
+		struct concat<type_list<As...>> { using type = type_list<As...>; };
+
+		template <typename... As, typename... Bs, typename... Ls>
+		struct concat<type_list<As...>, type_list<Bs...>, Ls...> { using type = typename concat<type_list<As..., Bs...>, Ls...>::type; };
+
+		//Components iterated by the system (annotations removed)
+		template <typename T> struct viewed { using type = type_list<T>; };
+		template <typename... Ts> struct viewed<Reads<Ts...>> { using type = type_list<>; };
+		template <typename... Ts> struct viewed<Writes<Ts...>> { using type = type_list<>; };
+		template <> struct viewed<Exclusive> { using type = type_list<>; };
+		template <unsigned Hz> struct viewed<Rate<Hz>> { using type = type_list<>; };
+		template <unsigned N> struct viewed<Slices<N>> { using type = type_list<>; };
+		template <unsigned Us> struct viewed<Budget<Us>> { using type = type_list<>; };
+
+		template <typename... Ts>
+		using viewed_t = typename concat<typename viewed<Ts>::type...>::type;
+
+		//Appends the type identifiers of each type to the given list
+		template <typename... Ts>
+		void push_types(std::vector<AccessType> &v)
 		{
-			reg.view<Ts...>().each(
-				[f, info](auto entity, auto&... params) { f(info, entity, params...); }
-			);
+			(v.push_back(entt::registry<>::type<std::remove_const_t<Ts>>()), ...);
+		}
+
+		//Records the access implied by a single entry of the SYSTEM macro
+		template <typename T>
+		struct record
+		{
+			//Viewed components are written unless declared const
+			static void access(Access &a)
+			{
+				if constexpr (std::is_const_v<T>)
+					push_types<T>(a.reads);
+				else
+					push_types<T>(a.writes);
+			}
+
+			static void prepare(entt::registry<> &reg) { reg.view<std::remove_const_t<T>>(); }
+			static void timing(Timing&) {}
+		};
+
+		//Resources have no pool to prepare
+		template <typename T>
+		void prepare_one(entt::registry<> &reg)
+		{
+			if constexpr (!std::is_base_of_v<Resource, std::remove_const_t<T>>)
+				record<T>::prepare(reg);
+		}
+
+		template <typename... Ts>
+		struct record<Reads<Ts...>>
+		{
+			static void access(Access &a) { push_types<Ts...>(a.reads); }
+			static void prepare(entt::registry<> &reg) { (prepare_one<Ts>(reg), ...); }
+			static void timing(Timing&) {}
+		};
+
+		template <typename... Ts>
+		struct record<Writes<Ts...>>
+		{
+			static void access(Access &a) { push_types<Ts...>(a.writes); }
+			static void prepare(entt::registry<> &reg) { (prepare_one<Ts>(reg), ...); }
+			static void timing(Timing&) {}
+		};
+
+		template <>
+		struct record<Exclusive>
+		{
+			static void access(Access &a) { a.exclusive = true; }
+			static void prepare(entt::registry<>&) {}
+			static void timing(Timing&) {}
+		};
+
+		template <unsigned Hz>
+		struct record<Rate<Hz>>
+		{
+			static void access(Access&) {}
+			static void prepare(entt::registry<>&) {}
+			static void timing(Timing &t) { t.rate = Hz; }
+		};
+
+		template <unsigned N>
+		struct record<Slices<N>>
+		{
+			static void access(Access&) {}
+			static void prepare(entt::registry<>&) {}
+			static void timing(Timing &t) { t.slices = std::max(N, 1u); }
+		};
+
+		template <unsigned Us>
+		struct record<Budget<Us>>
+		{
+			static void access(Access&) {}
+			static void prepare(entt::registry<>&) {}
+			static void timing(Timing &t) { t.budget = Us / 1e6; }
 		};
+
+		//Whether the system may be asked to visit only a share of its entities
+		template <typename T> struct is_sliced : std::false_type {};
+		template <unsigned N> struct is_sliced<Slices<N>> : std::true_type {};
+
+		template <typename... Ts>
+		constexpr bool sliced_v = (is_sliced<Ts>::value || ...);
+
+		//Whether the entity falls in the share of entities this run should visit
+		inline bool in_slice(const SceneInfo &info, entt::registry<>::entity_type entity)
+		{
+			return info.registry.entity(entity) % info.slices == info.slice;
+		}
+
+		template <bool Sliced, typename F, typename... Cs>
+		void each(const F &f, SceneInfo info, entt::registry<> &reg, type_list<Cs...>)
+		{
+			reg.view<std::remove_const_t<Cs>...>().each(
+				[&f, info](auto entity, auto&... params) {
+					if constexpr (Sliced)
+						if (!in_slice(info, entity)) return;
+					f(info, entity, static_cast<Cs&>(params)...);
+				}
+			);
+		}
+
+		template <bool Sliced, typename F, typename... Cs>
+		void parallel_each(const F &f, SceneInfo info, entt::registry<> &reg, type_list<Cs...>)
+		{
+			ParallelInfo pinfo{ info.dt, reg, info.scene };
+			jobs::parallel_for_each<std::remove_const_t<Cs>...>(reg, PARALLEL_GRAIN,
+				[&f, info, pinfo](auto entity, auto&... params) {
+					if constexpr (Sliced)
+						if (!in_slice(info, entity)) return;
+					f(pinfo, entity, static_cast<Cs&>(params)...);
+				}
+			);
+		}
+	}
+
+	//Calls a system function for every entity with the given components (and annotations), inlined into the loop
+	template <typename... Ts, typename F>
+	void each(const F &f, SceneInfo info, entt::registry<> &reg)
+	{
+		detail::each<detail::sliced_v<Ts...>>(f, info, reg, detail::viewed_t<Ts...>{});
+	}
+
+	//As each, but split into chunks across the job system, passing ParallelInfo in place of SceneInfo
+	template <typename... Ts, typename F>
+	void parallel_each(const F &f, SceneInfo info, entt::registry<> &reg)
+	{
+		detail::parallel_each<detail::sliced_v<Ts...>>(f, info, reg, detail::viewed_t<Ts...>{});
 	}
 
-	//Dictionary of wrapped system functions
-	extern std::vector<SystemInvoker> system_invokers;
+	//Calls a system function once, for systems working over whole sets of entities
+	template <typename... Ts, typename F>
+	void once(const F &f, SceneInfo info, entt::registry<>&)
+	{
+		static_assert(std::is_same_v<detail::viewed_t<Ts...>, detail::type_list<>>, "Systems run once take only annotations");
+		f(info);
+	}
+
+	//Compile-time list of systems, run in order without any type erasure
+	template <typename... Ss>
+	struct Pipeline
+	{
+		static void run(SceneInfo info, entt::registry<> &reg)
+		{
+			(Ss::run(info, reg), ...);
+		}
+	};
 
-	//CRTP base class registering system function definitions
+	//CRTP base class registering system definitions, which provide a static run
 	template <typename T, typename... Ts>
 	struct System
 	{
-		System(const SystemFunction<Ts...> &f)
+		System(const char *name)
 		{
-			system_invokers.emplace_back(system_invoker(f));
+			system_invokers.push_back({ name, &T::run, &access, &prepare, &timing });
+		}
+
+	private:
+		static Access access()
+		{
+			Access a;
+			(detail::record<Ts>::access(a), ...);
+			return a;
+		}
+
+		static void prepare(entt::registry<> &reg)
+		{
+			(detail::prepare_one<Ts>(reg), ...);
+		}
+
+		static Timing timing()
+		{
+			Timing t;
+			(detail::record<Ts>::timing(t), ...);
+			return t;
 		}
 	};
 }
 
-//Registers a function as a system expecting an arbitrary number of components
+//Registers a function as a system expecting an arbitrary number of components.
+//Components may be const (read-only), and Reads<...>, Writes<...> and Exclusive
+//declare further access for the scheduler. Rate<Hz>, Slices<N> and Budget<us>
+//declare how often it runs and how long it may take.
 #define SYSTEM(name, ...) \
-	struct SYS_##name { static System<SYS_##name, __VA_ARGS__> s; }; \
+	struct SYS_##name \
+	{ \
+		static void run(SceneInfo info, entt::registry<> &reg) { each<__VA_ARGS__>(name, info, reg); } \
+		static System<SYS_##name, __VA_ARGS__> s; \
+	}; \
+	System<SYS_##name, __VA_ARGS__> SYS_##name::s ( \
+	#name )
+
+//Registers a function as a system run once per tick rather than per entity, taking only
+//SceneInfo. Only annotations (Reads<...>, Writes<...>, Rate<Hz> etc.) may be given.
+#define SYSTEM_ONCE(name, ...) \
+	struct SYS_##name \
+	{ \
+		static void run(SceneInfo info, entt::registry<> &reg) { once<__VA_ARGS__>(name, info, reg); } \
+		static System<SYS_##name, __VA_ARGS__> s; \
+	}; \
+	System<SYS_##name, __VA_ARGS__> SYS_##name::s ( \
+	#name )
+
+//Registers a function as a system run in parallel chunks of entities. It receives
+//ParallelInfo rather than SceneInfo, so can't change the scene's structure, and must
+//only modify its own components.
+#define SYSTEM_PARALLEL(name, ...) \
+	struct SYS_##name \
+	{ \
+		static void run(SceneInfo info, entt::registry<> &reg) { parallel_each<__VA_ARGS__>(name, info, reg); } \
+		static System<SYS_##name, __VA_ARGS__> s; \
+	}; \
 	System<SYS_##name, __VA_ARGS__> SYS_##name::s ( \
-	name )
+	#name )
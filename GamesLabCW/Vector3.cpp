@@ -15,14 +15,14 @@ game::Vector3::Vector3(glm::vec3 vec) : x(vec.x), y(vec.y), z(vec.z) {};
 
 double game::Vector3::abs() const { return sqrt(x*x + y*y + z*z); }
 
-glm::vec3 game::Vector3::ToGLM() { return glm::vec3(x, y, z); }
+glm::vec3 game::Vector3::ToGLM() const { return glm::vec3(x, y, z); }
 
-game::Vector3 game::Vector3::operator+(const Vector3 &other)
+game::Vector3 game::Vector3::operator+(const Vector3 &other) const
 {
 	return Vector3(this->x + other.x, this->y + other.y, this->z + other.z);
 }
 
-game::Vector3 game::Vector3::operator-(const Vector3 &other)
+game::Vector3 game::Vector3::operator-(const Vector3 &other) const
 {
 	return Vector3(this->x - other.x, this->y - other.y, this->z - other.z);
 }
@@ -43,12 +43,12 @@ game::Vector3& game::Vector3::operator-=(const Vector3 &other)
 	return *this;
 }
 
-game::Vector3 game::Vector3::operator*(const double &other)
+game::Vector3 game::Vector3::operator*(const double &other) const
 {
 	return Vector3(this->x * other, this->y * other, this->z * other);
 }
 
-game::Vector3 game::Vector3::operator/(const double &other)
+game::Vector3 game::Vector3::operator/(const double &other) const
 {
 	return Vector3(this->x / other, this->y / other, this->z / other);
 }
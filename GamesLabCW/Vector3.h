@@ -27,18 +27,18 @@ namespace game
 		//Returns the magnitude of this Vector3
 		double abs() const;
 
-		glm::vec3 ToGLM();
+		glm::vec3 ToGLM() const;
 
 		//Definitions of algebraic operations
 
-		Vector3 operator+(const Vector3 &other);
-		Vector3 operator-(const Vector3 &other);
+		Vector3 operator+(const Vector3 &other) const;
+		Vector3 operator-(const Vector3 &other) const;
 
 		Vector3& operator+=(const Vector3 &other);
 		Vector3& operator-=(const Vector3 &other);
 
-		Vector3 operator*(const double &other);
-		Vector3 operator/(const double &other);
+		Vector3 operator*(const double &other) const;
+		Vector3 operator/(const double &other) const;
 
 		//Allows implicit casting to glm
 		operator glm::vec3() const;
@@ -4,14 +4,56 @@
  */
 
 #include "GameEngine.h"
+#include "HeadlessEngine.h"
+#include "Benchmarks.h"
+#include "Jobs.h"
 
 #include <iostream>
 #include <exception>
+#include <string>
 
 int main(int argc, char **argv)
 {
 	try
 	{
+		//Parse launch options: --headless [--maze] [--ticks n] [--grid], or --bench name
+		bool headless = false, maze = false;
+		game::Broadphase::Kind broadphase = game::BROADPHASE;
+		std::string bench;
+		unsigned long ticks = 10 * game::GAME_RATE;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "--headless") headless = true;
+			else if (arg == "--maze") maze = true;
+			else if (arg == "--ticks" && i + 1 < argc)
+			{
+				ticks = std::stoul(argv[++i]);
+				if (ticks == 0)
+				{
+					std::cerr << "--ticks must be at least 1" << std::endl;
+					return EXIT_FAILURE;
+				}
+			}
+			else if (arg == "--grid") broadphase = game::Broadphase::Kind::Grid;
+			else if (arg == "--bench" && i + 1 < argc) bench = argv[++i];
+		}
+
+		//Run a microbenchmark instead of the game
+		if (!bench.empty())
+		{
+			game::jobs::init();
+			return game::benchmarks::run(bench) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		//Run the simulation alone, without a window or graphics context
+		if (headless)
+		{
+			game::HeadlessEngine sim(maze, broadphase);
+			sim.run(ticks);
+			return EXIT_SUCCESS;
+		}
+
 		//Instantiate the engine
 		game::GameEngine app(false, true, false);
 
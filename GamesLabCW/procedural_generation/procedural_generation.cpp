@@ -56,6 +56,22 @@ namespace game::procgen
 	public:
 		using Coords = std::pair<int, int>;
 
+		//Parameters of model
+		static constexpr double MODEL_SIZE = 20.0;
+		static constexpr double SCALE = 1.2;
+
+		//Effective size
+		static constexpr double CELL_SIZE = MODEL_SIZE * SCALE;
+
+		//Separation between cells to prevent z-fighting
+		static constexpr double GIVE = -0.001;
+
+		//Distance between the centres of neighbouring cells
+		static constexpr double PITCH = CELL_SIZE + GIVE;
+
+		//Size of individual solid planes
+		static constexpr double PLANE_SIZE = CELL_SIZE / 2 + 2;
+
 		//Construct grid, with the given odd width/height
 		Grid(size_t size) : size_(size), grid_(size * size)
 		{
@@ -371,6 +387,87 @@ namespace game::procgen
 				populate_rooms(n, min_size, max_size - 1, id_from);
 		}
 
+		//Straight run of walls along the same side of neighbouring open cells
+		struct WallRun
+		{
+			Coords first, last; //Cells at either end
+			int dx, dy; //Offset from each cell to the solid neighbour its wall faces
+		};
+
+		//Offsets to each neighbour a wall may face
+		static constexpr int SIDES[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+		//Whether the given cell is open and faces a solid neighbour at the given offset
+		bool walled(int x, int y, int dx, int dy) const
+		{
+			return x >= 1 && y >= 1 && x < int(size_) - 1 && y < int(size_) - 1 &&
+				!grid_[coords_to_index(x, y)].solid && grid_[coords_to_index(x + dx, y + dy)].solid;
+		}
+
+		//Gets the longest straight runs of walls between open cells and solid ones
+		std::vector<WallRun> wall_runs() const
+		{
+			std::vector<WallRun> runs;
+			for (auto &side : SIDES)
+			{
+				int dx = side[0], dy = side[1];
+
+				//Walls facing along x run along y, and vice versa
+				int ax = dy != 0, ay = dx != 0;
+
+				for (int x = 1; x < size_ - 1; x++)
+					for (int y = 1; y < size_ - 1; y++)
+						if (walled(x, y, dx, dy) && !walled(x - ax, y - ay, dx, dy))
+						{
+							int n = 0;
+							while (walled(x + ax * (n + 1), y + ay * (n + 1), dx, dy)) n++;
+							runs.push_back({ { x, y }, { x + ax * n, y + ay * n }, dx, dy });
+						}
+			}
+
+			return runs;
+		}
+
+		//Gets the solid collision planes of the maze's walls, either one per straight run of walls,
+		//or one round plane per walled side of each open cell as they were placed before runs were merged
+		std::vector<SolidPlaneComponent> wall_planes(bool merged) const
+		{
+			std::vector<SolidPlaneComponent> walls;
+			if (merged)
+			{
+				for (auto &run : wall_runs())
+				{
+					Vector3 first = { run.first.first * PITCH, 0, run.first.second * PITCH };
+					Vector3 last = { run.last.first * PITCH, 0, run.last.second * PITCH };
+					Vector3 offset = Vector3(run.dx, 0, run.dy) * (CELL_SIZE / 2);
+					walls.push_back({ { double(-run.dx), 0, double(-run.dy) }, (first + last) / 2.0 + offset, PLANE_SIZE, (last - first) / 2.0 });
+				}
+			}
+			else
+			{
+				for (int x = 1; x < size_ - 1; x++)
+					for (int y = 1; y < size_ - 1; y++)
+						for (auto &side : SIDES)
+							if (walled(x, y, side[0], side[1]))
+							{
+								Vector3 centre = { x * PITCH, 0, y * PITCH };
+								walls.push_back({ { double(-side[0]), 0, double(-side[1]) }, centre + Vector3(side[0], 0, side[1]) * (CELL_SIZE / 2), PLANE_SIZE });
+							}
+			}
+
+			return walls;
+		}
+
+		//Gets every open cell
+		std::vector<Coords> open_cells() const
+		{
+			std::vector<Coords> cells;
+			for (size_t i = 0; i < grid_.size(); i++)
+				if (!grid_[i].solid)
+					cells.push_back(index_to_coords(i));
+			return cells;
+		}
+
 		//Builds the maze into the given scene, returning suggested player position
 		Vector3 build_scene(Scene &scene)
 		{
@@ -419,19 +516,6 @@ namespace game::procgen
 			ModelComponent m_type_4; m_type_4.model_file = "models/Procedural/type4.obj";
 			ModelComponent m_type_5; m_type_5.model_file = "models/Procedural/type5.obj";
 
-			//Parameters of model
-			double model_size = 20.0;
-			double scale = 1.2;
-
-			//Effective size
-			double cell_size = model_size * scale;
-
-			//Separation between cells to prevent z-fighting
-			double give = -0.001;
-
-			//Size of individual solid planes
-			double plane_size = cell_size / 2 + 2;
-
 			//Has the key been instantiated yet?
 			bool key = false;
 			Coords key_pos;
@@ -444,8 +528,8 @@ namespace game::procgen
 					{
 						//Universally applicable transformation
 						TransformComponent t;
-						t.position = { x * (cell_size + give), 0, y * (cell_size + give) };
-						t.scale = { scale, scale, scale };
+						t.position = { x * PITCH, 0, y * PITCH };
+						t.scale = { SCALE, SCALE, SCALE };
 
 						//Determine number of solid neighbours
 						int num_neighbours = 0;
@@ -478,12 +562,12 @@ namespace game::procgen
 							//Corridor piece
 							if (east && west)
 							{
-								t.position.y += 0.1 * scale; //Account for slight gap
+								t.position.y += 0.1 * SCALE; //Account for slight gap
 								scene.instantiate("Model", m_type_1, t);
 							}
 							else if (north && south)
 							{
-								t.position.y += 0.1 * scale; //Account for slight gap
+								t.position.y += 0.1 * SCALE; //Account for slight gap
 								t.rotation = { 0, 90.0, 0 };
 								scene.instantiate("Model", m_type_1, t);
 							}
@@ -497,7 +581,7 @@ namespace game::procgen
 								scene.instantiate("Model", m_type_2, t);
 
 								//Instantiate torch
-								place_torch({ x * cell_size, -11.5, y * cell_size });
+								place_torch({ x * CELL_SIZE, -11.5, y * CELL_SIZE });
 							}
 							break;
 
@@ -512,21 +596,19 @@ namespace game::procgen
 							//Instantiate key
 							if (!key)
 							{
-								place_key({ x * cell_size, 0.5, y * cell_size });
+								place_key({ x * CELL_SIZE, 0.5, y * CELL_SIZE });
 								key_pos = { x, y };
 								key = true;
 							}
 
 							break;
 						}
-
-						//Place solid collision planes
-						if (west) scene.instantiate("SolidPlane", SolidPlaneComponent{ { 1, 0, 0 }, t.position + Vector3(-cell_size / 2, 0, 0), plane_size });
-						if (east) scene.instantiate("SolidPlane", SolidPlaneComponent{ { -1, 0, 0 }, t.position + Vector3(cell_size / 2, 0, 0), plane_size });
-						if (north) scene.instantiate("SolidPlane", SolidPlaneComponent{ { 0, 0, 1 }, t.position + Vector3(0, 0, -cell_size / 2), plane_size });
-						if (south) scene.instantiate("SolidPlane", SolidPlaneComponent{ { 0, 0, -1 }, t.position + Vector3(0, 0, cell_size / 2), plane_size });
 					}
 
+			//Place solid collision planes, one per straight run of walls rather than per cell side
+			for (auto &w : wall_planes(true))
+				scene.instantiate("SolidPlane", w);
+
 			//If there were no dead ends, place key in random cell
 			if (!key)
 			{
@@ -536,7 +618,7 @@ namespace game::procgen
 					i = index_dist(rng());
 
 				auto [x, y] = index_to_coords(i);
-				place_key({ x * cell_size, 0.5, y * cell_size });
+				place_key({ x * CELL_SIZE, 0.5, y * CELL_SIZE });
 				key_pos = { x, y };
 				key = true;
 			}
@@ -556,9 +638,9 @@ namespace game::procgen
 						player_pos = { x, y };
 				}
 
-			Vector3 playerPos = { player_pos.first * cell_size, 6, player_pos.second * cell_size };
+			Vector3 playerPos = { player_pos.first * CELL_SIZE, 6, player_pos.second * CELL_SIZE };
 
-			auto player = scene.instantiate("FirstPersonController", FirstPersonControllerComponent{ 45.0f }, TransformComponent{ playerPos , { 180,0,0 } }, CollisionComponent{ 6 }, KinematicComponent{ true });
+			auto player = scene.instantiate("FirstPersonController", FirstPersonControllerComponent{ 45.0f }, TransformComponent{ playerPos , { 180,0,0 } }, KinematicComponent{ true });
 			auto camera = scene.instantiate("Camera", CameraComponent{ player });
 
 			// Minotaur setup
@@ -574,14 +656,15 @@ namespace game::procgen
 				TransformComponent t_minotaur; t_minotaur.scale = { 0.15, 0.15, 0.15 }; t_minotaur.position = transforms[i].position; t_minotaur.position.y = -5; /*t_minotaur.rotation = { 90, 180, 0 };*/
 				HitboxComponent h_minotaur; h_minotaur.c.radius = 4;
 				StatsComponent s_minotaur; s_minotaur.health = 3, s_minotaur.mana = 0;
-				scene.instantiate("AIModel", m_minotaur, c_minotaur, t_minotaur, h_minotaur, d_minotaur, s_minotaur, CollisionComponent{ 1 }, KinematicComponent{ true });
+				scene.instantiate("AIModel", m_minotaur, c_minotaur, t_minotaur, h_minotaur, d_minotaur, s_minotaur, KinematicComponent{ true });
 			}
 
 			return playerPos;
 		}
 	};
 
-	Vector3 generate_maze(Scene &scene, size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size)
+	//Generates the grid of a game maze
+	Grid generate_grid(size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size)
 	{
 		//Prepare fully-solid grid
 		Grid g(grid_size);
@@ -596,18 +679,31 @@ namespace game::procgen
 		if (g.number_solid() < grid_size * grid_size)
 			g.populate_rooms(number_rooms, min_room_size, max_room_size);
 
+		return g;
+	}
+
+	Vector3 generate_maze(Scene &scene, size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size)
+	{
+		Grid g = generate_grid(grid_size, sparsification, number_rooms, min_room_size, max_room_size);
+
 		//Print minimap to console
 		g.print();
 
 		//Build the map into the scene
 		return g.build_scene(scene);
 	}
+
+	MazeWalls generate_maze_walls(size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size)
+	{
+		Grid g = generate_grid(grid_size, sparsification, number_rooms, min_room_size, max_room_size);
+		return { Grid::PITCH, g.open_cells(), g.wall_planes(true), g.wall_planes(false) };
+	}
 	
 	void load_hub(Scene &scene, int keys_collected)
 	{
 		//Player/camera
 		StatsComponent s_player; s_player.health = 3; s_player.mana = 0; s_player.keyCount = keys_collected;
-		auto player = scene.instantiate("FirstPersonController", FirstPersonControllerComponent{ 25.0f }, TransformComponent{ {30,6,0} , { -90,0,0 } }, CollisionComponent{ 6 }, KinematicComponent{ true }, s_player);
+		auto player = scene.instantiate("FirstPersonController", FirstPersonControllerComponent{ 25.0f }, TransformComponent{ {30,6,0} , { -90,0,0 } }, KinematicComponent{ true }, s_player);
 		auto camera = scene.instantiate("Camera", CameraComponent{ player });
 
 		//Room stuff
@@ -676,14 +772,6 @@ namespace game::procgen
 		scene.instantiate("Portal", TransformComponent{ { 3, 3, 22 } });
 		scene.instantiate("Door", TransformComponent{ { -30, 12, 0 } });
 
-		//UI
-		OverlayComponent i_hp; i_hp.texture_file = "models/UI/hearts-2.png";
-		scene.instantiate("Overlay", i_hp);
-		OverlayComponent i_mp; i_mp.texture_file = "models/UI/mana-3.png";
-		scene.instantiate("Overlay", i_mp);
-		OverlayComponent i_ch; i_ch.texture_file = "models/UI/crosshair.png";
-		scene.instantiate("Overlay", i_ch);
-
 		//Skybox
 		TransformComponent t_skybox; t_skybox.scale = { 20, 20, 20 };
 		ModelComponent m_skybox; m_skybox.model_file = "models/Skybox/skybox.obj"; m_skybox.vertex_shader = "shaders/Skybox.vert"; m_skybox.fragment_shader = "shaders/Skybox.frag";
@@ -6,7 +6,11 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "../Scene.h"
+#include "../Components.h"
 
 namespace game
 {
@@ -15,6 +19,19 @@ namespace game
 		//Generate a game maze, returning the suggested player position
 		Vector3 generate_maze(Scene &scene, size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size);
 
+		//Collision planes of a maze's walls, placed both as generate_maze places them and as they were before
+		//straight runs were merged, so the two can be checked to block the same cells
+		struct MazeWalls
+		{
+			double pitch; //Distance between the centres of neighbouring cells
+			std::vector<std::pair<int, int>> open; //Open cells, centred at pitch times their coordinates
+			std::vector<SolidPlaneComponent> merged; //One plane per straight run of walls
+			std::vector<SolidPlaneComponent> per_side; //One round plane per walled side of each open cell
+		};
+
+		//Generate the walls of a game maze without building it into a scene
+		MazeWalls generate_maze_walls(size_t grid_size, int sparsification, int number_rooms, int min_room_size, int max_room_size);
+
 		//Load the main hub level
 		void load_hub(Scene &scene, int keys_collected = 0);
 	}
@@ -1,5 +1,8 @@
 #include "Model.h"
 
+#include "Shader.h"
+
+#include <algorithm>
 #include <iostream>
 
 namespace game
@@ -119,6 +122,9 @@ namespace game
 			currentIndices += mesh->mNumFaces * 3;
 		}
 		vertices_backup = vertices;
+
+		for (const VertexData &v : vertices)
+			boundingRadius = std::max(boundingRadius, glm::length(v.pos));
 	}
 
 	void Model::loadMaterials(const aiScene *scene, std::string modelPath)
@@ -231,7 +237,7 @@ namespace game
 		ebo.upload(GL_STATIC_DRAW);
 	}
 
-	void Model::Render(GLuint shaderProgram)
+	void Model::Render(const Shader &shader)
 	{
 		// Drawing stuff
 		glBindVertexArray(vao);
@@ -247,7 +253,7 @@ namespace game
 				Texture &diffuseMap = diffuseMaps[materialIDs[i]];
 				glActiveTexture(GL_TEXTURE0);
 				glBindTexture(GL_TEXTURE_2D, diffuseMap.handle);
-				glUniform1i(glGetUniformLocation(shaderProgram, "texSampler"), 0);
+				glUniform1i(shader.uniform(uniforms::texSampler), 0);
 
 				offset++;
 			}
@@ -258,7 +264,7 @@ namespace game
 				Texture &normalMap = normalMaps[materialIDs[i]];
 				glActiveTexture(GL_TEXTURE0 + offset);
 				glBindTexture(GL_TEXTURE_2D, normalMap.handle);
-				glUniform1i(glGetUniformLocation(shaderProgram, "normalSampler"), offset);
+				glUniform1i(shader.uniform(uniforms::normalSampler), offset);
 
 				offset++;
 			}
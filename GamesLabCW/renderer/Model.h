@@ -14,6 +14,8 @@
 
 namespace game
 {
+	class Shader;
+
 	/*
 		Stores per-vertex information on the model in a convenient object for easy passing to buffers.
 	*/
@@ -82,6 +84,9 @@ namespace game
 		// Buffer data: all of the vertices (including positions, uv, normal data etc.) and indices in the model
 		std::vector<VertexData> vertices;
 		std::vector<VertexData> vertices_backup;
+
+		// Distance from the origin to the furthest vertex, before any animation
+		float boundingRadius = 0.0f;
 		std::vector<unsigned int> indices;
 
 		// Drawing related stuff: since one model can have multiple meshes, we need to track where to start drawing from and for how long
@@ -148,12 +153,13 @@ namespace game
 	public:
 		Model::Model(std::string path);
 
-		void Model::Render(GLuint shaderProgram);
+		void Model::Render(const Shader &shader);
 		void Model::Animate(double time);
 
 		const bool Model::IsTextured() { return isTextured; }
 		const bool Model::IsNormalMapped() { return isNormalMapped; }
 		const bool Model::IsAnimated() { return bones.size() > 0; }
+		const float Model::BoundingRadius() { return boundingRadius; }
 	};
 }
 
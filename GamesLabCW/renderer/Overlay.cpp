@@ -1,9 +1,17 @@
 #include "Overlay.h"
 
+#include "Shader.h"
+
 namespace game
 {
+	GLuint Overlay::vao = 0;
+	GLint Overlay::positionLocation = -1;
+
 	Overlay::Overlay(Texture texture, Vector2 position) : texture(texture), position(position)
 	{
+		// The quad is the same for every overlay, so only build it once
+		if (vao) return;
+
 		// Set up mesh and attribute properties
 		GLuint vbo;
 
@@ -17,11 +25,11 @@ namespace game
 			1.0f, -1.0f, 1.0f, 0.0f
 		};
 
-		glGenVertexArrays(1, &this->vao);
+		glGenVertexArrays(1, &vao);
 		glGenBuffers(1, &vbo);
 
 		// Build up vertex/tex coord info for the vbo
-		glBindVertexArray(this->vao);
+		glBindVertexArray(vao);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(squareCoords), squareCoords, GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
@@ -29,20 +37,25 @@ namespace game
 		glBindVertexArray(0);
 	}
 
-	void Overlay::Render(GLuint shaderProgram)
+	void Overlay::Begin(const Shader &shader)
 	{
+		positionLocation = shader.uniform(uniforms::position);
+
+		glActiveTexture(GL_TEXTURE0);
+		glUniform1i(shader.uniform(uniforms::texSampler), 0);
 		glBindVertexArray(vao);
+	}
 
-		glUniform2f(
-			glGetUniformLocation(shaderProgram, "position"),
-			(GLfloat)position.x, (GLfloat)position.y
-		);
+	void Overlay::End()
+	{
+		glBindVertexArray(0);
+	}
+
+	void Overlay::Render()
+	{
+		glUniform2f(positionLocation, (GLfloat)position.x, (GLfloat)position.y);
 
-		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, texture.handle);
-		glUniform1i(glGetUniformLocation(shaderProgram, "texSampler"), 0);
-		glBindVertexArray(this->vao);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
 	}
 }
\ No newline at end of file
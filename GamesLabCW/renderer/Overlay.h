@@ -5,13 +5,25 @@
 
 namespace game
 {
+	class Shader;
+
 	class Overlay
 	{
 	public:
 		Overlay(Texture texture, Vector2 position);
-		void Render(GLuint shaderProgram);
+
+		// Prepares the shared quad and sampler for a pass of Render calls
+		static void Begin(const Shader &shader);
+		static void End();
+
+		void Render();
 	private:
-		GLuint vao;
+		// Screen quad shared by every overlay
+		static GLuint vao;
+
+		// Location of the position uniform in the current pass
+		static GLint positionLocation;
+
 		Texture texture;
 		Vector2 position;
 	};
@@ -1,5 +1,7 @@
 #include "ParticleEffect.h"
 
+#include "Shader.h"
+
 namespace game
 {
 	ParticleEffect::ParticleEffect(Texture texture, int amount, float scale, float speed) : texture(texture), amount(amount), scale(scale), speed(speed)
@@ -65,7 +67,7 @@ namespace game
 		}
 	}
 
-	void ParticleEffect::Render(GLuint shaderProgram)
+	void ParticleEffect::Render(const Shader &shader)
 	{
 		// Bind array object and blend
 		glBindVertexArray(vao);
@@ -77,24 +79,24 @@ namespace game
 			if (particle.Life > 0.0f)
 			{
 				glUniform1f(
-					glGetUniformLocation(shaderProgram, "scale"),
+					shader.uniform(uniforms::scale),
 					(GLfloat)particle.Scale
 				);
 
 				glUniform3f(
-					glGetUniformLocation(shaderProgram, "offset"),
+					shader.uniform(uniforms::offset),
 					(GLfloat)particle.Position.x, (GLfloat)particle.Position.y, (GLfloat)particle.Position.z
 				);
 
 				glUniform4f(
-					glGetUniformLocation(shaderProgram, "color"),
+					shader.uniform(uniforms::color),
 					(GLfloat)particle.Color.x, (GLfloat)particle.Color.y, (GLfloat)particle.Color.z,
 					(GLfloat)particle.Color.w
 				);
 
 				glActiveTexture(GL_TEXTURE0);
 				glBindTexture(GL_TEXTURE_2D, texture.handle);
-				glUniform1i(glGetUniformLocation(shaderProgram, "texSampler"), 0);
+				glUniform1i(shader.uniform(uniforms::texSampler), 0);
 				glBindVertexArray(this->vao);
 				glDrawArrays(GL_TRIANGLES, 0, 6);
 				glBindVertexArray(0);
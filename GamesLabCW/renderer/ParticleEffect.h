@@ -5,6 +5,8 @@
 
 namespace game
 {
+	class Shader;
+
 	struct Particle 
 	{
 		glm::vec3 Position;
@@ -20,7 +22,7 @@ namespace game
 	public:
 		ParticleEffect(Texture texture, int amount, float scale, float speed);
 		void Update(float dt, int newParticles, Vector3 positionVariation, Vector3 velocityVariation, Vector3 colorVariation, glm::vec3 offset = glm::vec3(0.0f, 0.0f, 0.0f));
-		void Render(GLuint shaderProgram);
+		void Render(const Shader &shader);
 	private:
 		std::vector<Particle> particles;
 		int amount;
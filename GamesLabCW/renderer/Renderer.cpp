@@ -7,6 +7,8 @@
 
 #include "Renderer.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <map>
 
 #include <glm/glm.hpp>
@@ -21,6 +23,8 @@
 #include "Model.h"
 #include "ParticleEffect.h"
 #include "Overlay.h"
+#include "../LightClusters.h"
+#include "../LightSelection.h"
 
 //Quick conversion to radians
 #define R(x) glm::radians((float)x)
@@ -43,22 +47,64 @@ namespace game::renderer
 		glEnable(GL_CULL_FACE);
 	}
 
+	//Lights as laid out in the std140 Lights block of ParametrisedFragment.frag
+	struct AmbientLightData { GLfloat colour[3]; GLfloat intensity; GLint on; GLfloat pad[3]; };
+	struct DirectionalLightData { GLfloat colour[3]; GLfloat intensity; GLfloat direction[3]; GLint on; };
+	struct PointLightData { GLfloat colour[3]; GLfloat intensity; GLfloat position[3]; GLfloat constant, linear, exponent; GLint on; GLfloat pad; };
+
+	struct LightsData
+	{
+		GLint n_ambient, n_directional, n_point, pad;
+
+		//Tiles per pixel and viewport origin, then near depth and slices per unit of log depth
+		GLfloat cluster_tiles[4];
+		GLfloat cluster_depth[4];
+
+		AmbientLightData ambient[MAX_AMBIENT_LIGHTS];
+		DirectionalLightData directional[MAX_DIRECTIONAL_LIGHTS];
+		PointLightData point[MAX_POINT_LIGHTS];
+	};
+
+	static_assert(sizeof(AmbientLightData) == 32 && sizeof(DirectionalLightData) == 32 && sizeof(PointLightData) == 48,
+		"Light layouts must match std140");
+	static_assert(offsetof(LightsData, ambient) == 48, "Light arrays must follow the counts as in std140");
+	static_assert(MAX_POINT_LIGHTS <= LIGHT_SET_CAPACITY, "Every point light must fit in a LightSet");
+
+	//Binding point of the Lights block in every program
+	constexpr GLuint LIGHTS_BINDING = 0;
+
+	//Buffer backing the Lights block
+	GLuint lights_buffer = 0;
+
+	//Texture units of the cluster buffers in every program
+	constexpr GLint CLUSTERS_UNIT = 4;
+	constexpr GLint CLUSTER_LIGHTS_UNIT = 5;
+
+	//Point lights of the frame binned by view-space cluster, from the projection's near plane to the render
+	//distance, and the buffers and textures they are read through
+	LightClusters light_clusters(0.1, RENDER_DISTANCE);
+	GLuint clusters_buffer = 0, clusters_texture = 0;
+	GLuint cluster_lights_buffer = 0, cluster_lights_texture = 0;
+
+	//Programs compiled in total, and by the time loading finished
+	size_t shaders_compiled = 0;
+	size_t shaders_compiled_loading = 0;
+	bool loading = true;
+
 	//Returns the (potentially cached) shader using the given paramaters
-	GLuint get_shader(
-		bool textured, bool normal_mapped, size_t n_ambient, size_t n_directional, size_t n_point, std::string vertex_shader, std::string fragment_shader)
+	const Shader &get_shader(bool textured, bool normal_mapped, std::string vertex_shader, std::string fragment_shader)
 	{
-		using Args = std::tuple<bool, bool, size_t, size_t, size_t, std::string, std::string>;
+		using Args = std::tuple<bool, bool, std::string, std::string>;
 
 		//Cache of parametrised shaders
 		static std::map<Args, Shader> shaders;
 
-		Args args = std::make_tuple(textured, normal_mapped, n_ambient, n_directional, n_point,
-			vertex_shader, fragment_shader);
+		Args args = std::make_tuple(textured, normal_mapped, vertex_shader, fragment_shader);
 
 		//If the requested shader already exists, return it
 		auto it = shaders.find(args);
 		if (it != shaders.end())
-			return it->second.handle();
+			return it->second;
 
 		//Else, compile and return the new shader
 		else
@@ -69,9 +115,12 @@ namespace game::renderer
 
 			if (textured) define(f, "TEXTURED");
 			if (normal_mapped) define(f, "NORMAL_MAPPED");
-			define(f, "N_AMBIENT " + std::to_string(n_ambient));
-			define(f, "N_DIRECTIONAL " + std::to_string(n_directional));
-			define(f, "N_POINT " + std::to_string(n_point));
+			define(f, "MAX_AMBIENT " + std::to_string(MAX_AMBIENT_LIGHTS));
+			define(f, "MAX_DIRECTIONAL " + std::to_string(MAX_DIRECTIONAL_LIGHTS));
+			define(f, "MAX_POINT " + std::to_string(MAX_POINT_LIGHTS));
+			define(f, "CLUSTERS_X " + std::to_string(LightClusters::X));
+			define(f, "CLUSTERS_Y " + std::to_string(LightClusters::Y));
+			define(f, "CLUSTERS_Z " + std::to_string(LightClusters::Z));
 
 			//Create new shader
 			auto &s = shaders[args];
@@ -79,7 +128,25 @@ namespace game::renderer
 				vertex_shader.empty() ? "shaders/Passthrough.vert" : vertex_shader.c_str(),
 				fragment_shader.empty() ? "shaders/ParametrisedFragment.frag" : fragment_shader.c_str(),
 				v, f);
-			return s.handle();
+
+			//Lit programs all read the frame's lights from the same buffer
+			GLuint block = glGetUniformBlockIndex(s.handle(), "Lights");
+			if (block != GL_INVALID_INDEX)
+				glUniformBlockBinding(s.handle(), block, LIGHTS_BINDING);
+
+			//As do their clusters, from units no material uses
+			if (s.uniform(uniforms::clusters) >= 0)
+			{
+				glUseProgram(s.handle());
+				glUniform1i(s.uniform(uniforms::clusters), CLUSTERS_UNIT);
+				glUniform1i(s.uniform(uniforms::clusterLights), CLUSTER_LIGHTS_UNIT);
+			}
+
+			shaders_compiled++;
+			if (loading)
+				shaders_compiled_loading = shaders_compiled;
+
+			return s;
 		}
 	}
 
@@ -104,14 +171,35 @@ namespace game::renderer
 
 	void load_model(std::string file) {
 		models.emplace(file, std::make_unique<Model>(file)).first->second;
+		load_shader(file);
+	}
+
+	void load_shader(std::string model_file, std::string vertex_shader, std::string fragment_shader)
+	{
+		auto it = models.find(model_file);
+		if (it == models.end()) return;
+
+		get_shader(it->second->IsTextured(), it->second->IsNormalMapped(), vertex_shader, fragment_shader);
 	}
 
 	void load_particle_effect(std::string texture, int count, float scale, float speed) {
 		particleEffects.emplace(texture, std::make_unique<ParticleEffect>(texture, count, scale, speed)).first->second;
+		get_shader(false, false, "shaders/Particle.vert", "shaders/Particle.frag");
 	}
 
 	void load_overlay(std::string file, Vector2 position) {
 		overlays.emplace(file, std::make_unique<Overlay>(file, position)).first->second;
+		get_shader(false, false, "shaders/Overlay.vert", "shaders/Overlay.frag");
+	}
+
+	void finish_loading()
+	{
+		loading = false;
+	}
+
+	size_t late_shader_compiles()
+	{
+		return shaders_compiled - shaders_compiled_loading;
 	}
 
 	void load_external_map(std::string path, std::string model_path, TextureType type)
@@ -129,9 +217,111 @@ namespace game::renderer
 		externalTextures.emplace(model_path, cubemap); // Need to map this texture with a model, since it was loaded externally
 	}
 
-	void render_model(CameraComponent camera, ModelComponent &m, ColourComponent c, TransformComponent t,
-		size_t n_ambient, AmbientLightComponent *ambients, size_t n_directional, DirectionalLightComponent *directionals,
-		size_t n_point, PointLightComponent *points)
+	void upload_lights(size_t n_ambient, const AmbientLightComponent *ambients,
+		size_t n_directional, const DirectionalLightComponent *directionals,
+		size_t n_point, const PointLightComponent *points)
+	{
+		static LightsData data;
+
+		data.n_ambient = (GLint)std::min(n_ambient, MAX_AMBIENT_LIGHTS);
+		for (GLint i = 0; i < data.n_ambient; i++)
+		{
+			const AmbientLightComponent &l = ambients[i];
+			data.ambient[i] = { { (GLfloat)l.colour.x, (GLfloat)l.colour.y, (GLfloat)l.colour.z },
+				(GLfloat)l.intensity, (GLint)l.on };
+		}
+
+		data.n_directional = (GLint)std::min(n_directional, MAX_DIRECTIONAL_LIGHTS);
+		for (GLint i = 0; i < data.n_directional; i++)
+		{
+			const DirectionalLightComponent &l = directionals[i];
+			data.directional[i] = { { (GLfloat)l.colour.x, (GLfloat)l.colour.y, (GLfloat)l.colour.z },
+				(GLfloat)l.intensity, { (GLfloat)l.direction.x, (GLfloat)l.direction.y, (GLfloat)l.direction.z },
+				(GLint)l.on };
+		}
+
+		data.n_point = (GLint)std::min(n_point, MAX_POINT_LIGHTS);
+		for (GLint i = 0; i < data.n_point; i++)
+		{
+			const PointLightComponent &l = points[i];
+			data.point[i] = { { (GLfloat)l.colour.x, (GLfloat)l.colour.y, (GLfloat)l.colour.z },
+				(GLfloat)l.intensity, { (GLfloat)l.position.x, (GLfloat)l.position.y, (GLfloat)l.position.z },
+				(GLfloat)l.constant, (GLfloat)l.linear, (GLfloat)l.exponent, (GLint)l.on };
+		}
+
+		if (!lights_buffer)
+		{
+			glGenBuffers(1, &lights_buffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, lights_buffer);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsData), nullptr, GL_DYNAMIC_DRAW);
+			glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, lights_buffer);
+		}
+
+		//Orphan last frame's storage rather than waiting on draws still reading it
+		glBindBuffer(GL_UNIFORM_BUFFER, lights_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsData), nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightsData), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	void upload_light_clusters(CameraComponent camera, size_t n_point, const PointLightComponent *points)
+	{
+		static std::vector<LightClusters::Light> lights;
+		lights.clear();
+		for (size_t i = 0; i < std::min(n_point, MAX_POINT_LIGHTS); i++)
+			lights.push_back(cluster_light(points[i]));
+
+		light_clusters.build(view_matrix(camera), camera.fov, ASPECT_RATIO_VAL, lights.data(), lights.size());
+
+		if (!clusters_buffer)
+		{
+			glGenBuffers(1, &clusters_buffer);
+			glGenBuffers(1, &cluster_lights_buffer);
+			glGenTextures(1, &clusters_texture);
+			glGenTextures(1, &cluster_lights_texture);
+		}
+
+		//Spans of each cluster, then the lights they refer to, never empty so the textures are valid
+		auto &clusters = light_clusters.clusters();
+		auto &indices = light_clusters.indices();
+		static const std::uint32_t none = 0;
+
+		glBindBuffer(GL_TEXTURE_BUFFER, clusters_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, clusters.size() * sizeof(LightClusters::Cluster), clusters.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, cluster_lights_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(indices.size(), 1) * sizeof(std::uint32_t),
+			indices.empty() ? &none : indices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glActiveTexture(GL_TEXTURE0 + CLUSTERS_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, clusters_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, clusters_buffer);
+		glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHTS_UNIT);
+		glBindTexture(GL_TEXTURE_BUFFER, cluster_lights_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, cluster_lights_buffer);
+		glActiveTexture(GL_TEXTURE0);
+
+		//How fragments find their cluster, which depends on the viewport and camera
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		GLfloat params[8] = {
+			(GLfloat)LightClusters::X / viewport[2], (GLfloat)LightClusters::Y / viewport[3],
+			(GLfloat)viewport[0], (GLfloat)viewport[1],
+			(GLfloat)light_clusters.near_depth(), (GLfloat)light_clusters.slice_scale(), 0, 0 };
+
+		glBindBuffer(GL_UNIFORM_BUFFER, lights_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offsetof(LightsData, cluster_tiles), sizeof(params), params);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	double model_radius(const std::string &file)
+	{
+		auto it = models.find(file);
+		return it == models.end() ? 0.0 : it->second->BoundingRadius();
+	}
+
+	void render_model(CameraComponent camera, ModelComponent &m, ColourComponent c, TransformComponent t, LightSet lights)
 	{
 
 		//Get the model, aborting if not found
@@ -142,8 +332,8 @@ namespace game::renderer
 		m.isAnimated = model->IsAnimated();
 		
 		//Determine and use appropriate shader
-		GLuint shader = get_shader(model->IsTextured(), model->IsNormalMapped(), n_ambient, n_directional, n_point, m.vertex_shader, m.fragment_shader);
-		glUseProgram(shader);
+		const Shader &shader = get_shader(model->IsTextured(), model->IsNormalMapped(), m.vertex_shader, m.fragment_shader);
+		glUseProgram(shader.handle());
 
 		//Calculate MVP matrices
 		glm::mat4 matProj = proj_matrix(camera);
@@ -174,18 +364,18 @@ namespace game::renderer
 			{
 			case TextureType::DIFFUSE:
 				glBindTexture(GL_TEXTURE_2D, texture.handle);
-				glUniform1i(glGetUniformLocation(shader, "texSampler"), 0);
+				glUniform1i(shader.uniform(uniforms::texSampler), 0);
 				break;
 			case TextureType::NORMAL:
 				glBindTexture(GL_TEXTURE_2D, texture.handle);
-				glUniform1i(glGetUniformLocation(shader, "normalSampler"), 0);
+				glUniform1i(shader.uniform(uniforms::normalSampler), 0);
 				break;
 			case TextureType::SPECULAR:
 				// Not yet implemented
 				break;
 			case TextureType::CUBE:
 				glBindTexture(GL_TEXTURE_CUBE_MAP, texture.handle);
-				glUniform1i(glGetUniformLocation(shader, "cubeSampler"), 0);
+				glUniform1i(shader.uniform(uniforms::cubeSampler), 0);
 				break;
 
 			default:
@@ -202,106 +392,42 @@ namespace game::renderer
 
 		//Provide MVP matrices
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "projectionMatrix"),
+			shader.uniform(uniforms::projectionMatrix),
 			1, GL_FALSE, glm::value_ptr(matProj)
 		);
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "viewMatrix"),
+			shader.uniform(uniforms::viewMatrix),
 			1, GL_FALSE, glm::value_ptr(matView)
 		);
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "modelMatrix"),
+			shader.uniform(uniforms::modelMatrix),
 			1, GL_FALSE, glm::value_ptr(matModel)
 		);
 
 		//Provide flat colour component
 		glUniform4f(
-			glGetUniformLocation(shader, "flatColour"),
+			shader.uniform(uniforms::flatColour),
 			(GLfloat)c.colour.x, (GLfloat)c.colour.y, (GLfloat)c.colour.z,
 			(GLfloat)c.alpha
 		);
 
 		//Provide shininess value (used to determine how much specular highlighting the model will have)
 		glUniform1f(
-			glGetUniformLocation(shader, "shininess"),
+			shader.uniform(uniforms::shininess),
 			(GLfloat)m.shininess
 		);
 
 		// Provide camera position for eye calculations
 		glUniform3f(
-			glGetUniformLocation(shader, "cameraPosition"),
+			shader.uniform(uniforms::cameraPosition),
 			(GLfloat)camera.position.x, (GLfloat)camera.position.y, (GLfloat)camera.position.z
 		);
 
-		//Provide ambient lights information
-		for (size_t i = 0; i < n_ambient; i++)
-		{
-			std::string j = std::to_string(i);
-			glUniform3f(glGetUniformLocation(shader,
-				("ambientLights[" + j + "].colour").c_str()),
-				(GLfloat)ambients[i].colour.x,
-				(GLfloat)ambients[i].colour.y,
-				(GLfloat)ambients[i].colour.z);
-			glUniform1f(glGetUniformLocation(shader,
-				("ambientLights[" + j + "].intensity").c_str()),
-				(GLfloat)ambients[i].intensity);
-			glUniform1f(glGetUniformLocation(shader,
-				("ambientLights[" + j + "].on").c_str()),
-				(GLfloat)ambients[i].on);
-		}
-
-		//Provide directional lights information
-		for (size_t i = 0; i < n_directional; i++)
-		{
-			std::string j = std::to_string(i);
-			glUniform3f(glGetUniformLocation(shader,
-				("directionalLights[" + j + "].colour").c_str()),
-				(GLfloat)directionals[i].colour.x,
-				(GLfloat)directionals[i].colour.y,
-				(GLfloat)directionals[i].colour.z);
-			glUniform1f(glGetUniformLocation(shader,
-				("directionalLights[" + j + "].intensity").c_str()),
-				(GLfloat)directionals[i].intensity);
-			glUniform3f(glGetUniformLocation(shader,
-				("directionalLights[" + j + "].direction").c_str()),
-				(GLfloat)directionals[i].direction.x,
-				(GLfloat)directionals[i].direction.y,
-				(GLfloat)directionals[i].direction.z);
-			glUniform1f(glGetUniformLocation(shader,
-				("directionalLights[" + j + "].on").c_str()),
-				(GLfloat)directionals[i].on);
-		}
-
-		//Provide point lights information
-		for (size_t i = 0; i < n_point; i++)
-		{
-			std::string j = std::to_string(i);
-			glUniform3f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].colour").c_str()),
-				(GLfloat)points[i].colour.x,
-				(GLfloat)points[i].colour.y,
-				(GLfloat)points[i].colour.z);
-			glUniform1f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].intensity").c_str()),
-				(GLfloat)points[i].intensity);
-			glUniform3f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].position").c_str()),
-				(GLfloat)points[i].position.x,
-				(GLfloat)points[i].position.y,
-				(GLfloat)points[i].position.z);
-			glUniform1f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].constant").c_str()),
-				(GLfloat)points[i].constant);
-			glUniform1f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].linear").c_str()),
-				(GLfloat)points[i].linear);
-			glUniform1f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].exponent").c_str()),
-				(GLfloat)points[i].exponent);
-			glUniform1f(glGetUniformLocation(shader,
-				("pointLights[" + j + "].on").c_str()),
-				(GLfloat)points[i].on);
-		}
+		//Provide the point lights chosen for this model, as two halves of the set
+		glUniform2ui(
+			shader.uniform(uniforms::objectLights),
+			(GLuint)(lights & 0xFFFFFFFFu), (GLuint)(lights >> 32)
+		);
 
 		model->Render(shader);
 	}
@@ -315,8 +441,8 @@ namespace game::renderer
 		if (it == particleEffects.end()) return;
 		std::unique_ptr<ParticleEffect> &particle = it->second;
 
-		GLuint shader = get_shader(false, false, 0, 0, 0, "shaders/Particle.vert", "shaders/Particle.frag");
-		glUseProgram(shader);
+		const Shader &shader = get_shader(false, false, "shaders/Particle.vert", "shaders/Particle.frag");
+		glUseProgram(shader.handle());
 
 		//Calculate MVP matrices
 		glm::mat4 matProj = proj_matrix(camera);
@@ -331,15 +457,15 @@ namespace game::renderer
 
 		//Provide MVP matrices
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "projectionMatrix"),
+			shader.uniform(uniforms::projectionMatrix),
 			1, GL_FALSE, glm::value_ptr(matProj)
 		);
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "viewMatrix"),
+			shader.uniform(uniforms::viewMatrix),
 			1, GL_FALSE, glm::value_ptr(matView)
 		);
 		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "modelMatrix"),
+			shader.uniform(uniforms::modelMatrix),
 			1, GL_FALSE, glm::value_ptr(matModel)
 		);
 
@@ -348,46 +474,26 @@ namespace game::renderer
 		glEnable(GL_CULL_FACE);
 	}
 
-	void render_overlay(CameraComponent camera, OverlayComponent &i)
+	Overlay *get_overlay(const std::string &file)
 	{
-		glDisable(GL_CULL_FACE);
-
-		//Get the overlay, aborting if not found
-		auto it = overlays.find(i.texture_file);
-		if (it == overlays.end()) return;
-		std::unique_ptr<Overlay> &overlay = it->second;
-
-		GLuint shader = get_shader(false, false, 0, 0, 0, "shaders/Overlay.vert", "shaders/Overlay.frag");
-		glUseProgram(shader);
+		auto it = overlays.find(file);
+		return it == overlays.end() ? nullptr : it->second.get();
+	}
 
-		//Calculate MVP matrices
-		glm::mat4 matProj = proj_matrix(camera);
+	void render_overlays(const std::vector<Overlay*> &layers)
+	{
+		if (layers.empty()) return;
 
-		glm::mat4 matView = view_matrix(camera);
+		glDisable(GL_CULL_FACE);
 
-		glm::mat4 matModel = glm::mat4(1);
-			
-			/*glm::translate(glm::vec3(t.position)) *
-			glm::rotate(R(t.rotation.x), glm::vec3(1, 0, 0)) *
-			glm::rotate(R(t.rotation.z), glm::vec3(0, 0, 1)) *
-			glm::rotate(R(t.rotation.y), glm::vec3(0, 1, 0)) *
-			glm::scale(glm::vec3(t.scale));
-*/
-		//Provide MVP matrices
-		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "projectionMatrix"),
-			1, GL_FALSE, glm::value_ptr(matProj)
-		);
-		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "viewMatrix"),
-			1, GL_FALSE, glm::value_ptr(matView)
-		);
-		glUniformMatrix4fv(
-			glGetUniformLocation(shader, "modelMatrix"),
-			1, GL_FALSE, glm::value_ptr(matModel)
-		);
+		//One program and quad for the whole pass, changing only textures between layers
+		const Shader &shader = get_shader(false, false, "shaders/Overlay.vert", "shaders/Overlay.frag");
+		glUseProgram(shader.handle());
 
-		overlay->Render(shader);
+		Overlay::Begin(shader);
+		for (auto overlay : layers)
+			overlay->Render();
+		Overlay::End();
 
 		glEnable(GL_CULL_FACE);
 	}
@@ -6,21 +6,34 @@
 #pragma once
 
 #include "../Components.h"
+#include "../LightSelection.h"
 #include "Texture.h"
 
+#include <vector>
+
+namespace game
+{
+	class Overlay;
+	class Shader;
+}
+
 namespace game::renderer
 {
 	//Initialises the render system
 	void init();
 
-	GLuint get_shader(
-		bool textured, bool normal_mapped, size_t n_ambient, size_t n_directional, size_t n_point, std::string vertex_shader, std::string fragment_shader);
+	//Gets the (potentially cached) shader using the given parameters. Programs depend only on
+	//material features, not on the number of lights, so all may be compiled while loading
+	const Shader &get_shader(bool textured, bool normal_mapped, std::string vertex_shader, std::string fragment_shader);
 
 	glm::mat4 proj_matrix(CameraComponent camera);
 	glm::mat4 view_matrix(CameraComponent camera);
 
-	//Loads the given model
+	//Loads the given model, along with the program it is drawn with by default
 	void load_model(std::string file);
+
+	//Compiles the program the given loaded model is drawn with using the given shaders
+	void load_shader(std::string model_file, std::string vertex_shader = "", std::string fragment_shader = "");
 	void load_particle_effect(std::string texture, int count, float scale, float speed);
 	void load_overlay(std::string file, Vector2 position);
 
@@ -28,15 +41,37 @@ namespace game::renderer
 	void load_external_map(std::string path, std::string model_path, TextureType type);
 	void load_external_map(std::string paths[6], std::string model_path, TextureType type, bool skybox);
 
-	//Renders an individual model using the given camera
+	//Uploads the lights of the frame, once, to the buffer read by every lit program.
+	//Lights beyond the MAX_*_LIGHTS of each kind are ignored, so the most important should come first
+	void upload_lights(size_t n_ambient, const AmbientLightComponent *ambients,
+		size_t n_directional, const DirectionalLightComponent *directionals,
+		size_t n_point, const PointLightComponent *points);
+
+	//Bins the given point lights, as last uploaded, into the view-space clusters of the given camera
+	//and uploads them, so fragments only shade with the lights of their own cluster
+	void upload_light_clusters(CameraComponent camera, size_t n_point, const PointLightComponent *points);
+
+	//Gets the distance from a loaded model's origin to its furthest vertex, or zero if not loaded.
+	//Safe to call from any thread while no models are loading
+	double model_radius(const std::string &file);
+
+	//Renders an individual model using the given camera, lit by the given set of the lights last uploaded
 	void render_model(CameraComponent camera, ModelComponent &model, ColourComponent c, TransformComponent t,
-		size_t n_ambient, AmbientLightComponent *ambients,
-		size_t n_directional, DirectionalLightComponent *directionals,
-		size_t n_point, PointLightComponent *points);
+		LightSet lights = ~LightSet(0));
 
 	void render_particle(CameraComponent camera, ParticleComponent &model, ColourComponent c, TransformComponent t);
 
-	void render_overlay(CameraComponent camera, OverlayComponent &i);
+	//Gets the loaded overlay with the given texture, or nullptr if not loaded
+	Overlay *get_overlay(const std::string &file);
+
+	//Renders the given overlays over the scene in a single pass, back to front
+	void render_overlays(const std::vector<Overlay*> &layers);
+
+	//Marks the end of loading, after which programs should no longer need compiling
+	void finish_loading();
+
+	//Gets the number of programs compiled since loading finished, each a hitch. Should be zero
+	size_t late_shader_compiles();
 
 	void animate_model(double time, std::string model_file);
 
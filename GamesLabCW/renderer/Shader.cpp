@@ -1,5 +1,6 @@
 #include "Shader.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -90,11 +91,54 @@ bool game::Shader::load(const std::string name, const char* vertexFilename, cons
 		}
 	}
 
+	reflect();
+
 	std::cout << "Loaded GLSL program: '" << m_name << "'" << std::endl;
 
 	return true;
 }
 
+void game::Shader::reflect()
+{
+	m_uniforms.clear();
+
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(m_programObject, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_programObject, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::string name(std::max(maxLength, 1), '\0');
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_programObject, GLuint(i), maxLength, &length, &size, &type, &name[0]);
+
+		std::string n = name.substr(0, length);
+		GLint location = glGetUniformLocation(m_programObject, n.c_str());
+		if (location < 0) continue;
+
+		m_uniforms.emplace_back(uniform_id(n.c_str()), location);
+
+		//Arrays of basic types are named after their first element, but may be set through their own name
+		if (n.size() > 3 && n.compare(n.size() - 3, 3, "[0]") == 0)
+			m_uniforms.emplace_back(uniform_id(n.substr(0, n.size() - 3).c_str()), location);
+	}
+
+	std::sort(m_uniforms.begin(), m_uniforms.end());
+
+	for (size_t i = 1; i < m_uniforms.size(); i++)
+		if (m_uniforms[i].first == m_uniforms[i - 1].first)
+			std::cout << "Warning: uniform identifiers collide in GLSL program: '" << m_name << "'" << std::endl;
+}
+
+GLint game::Shader::uniform(UniformId id) const
+{
+	auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), id,
+		[](const std::pair<UniformId, GLint> &u, UniformId id) { return u.first < id; });
+	return it != m_uniforms.end() && it->first == id ? it->second : -1;
+}
+
 //reads the shader from a file and defines the shader source
 GLuint game::Shader::loadShader(const char* filename, GLenum type, std::string prepend) const
 {
@@ -1,12 +1,47 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace game
 {
 	const std::string GLSL_VERSION_DIRECTIVE = "#version 330 core\n";
 
+	//Identifier of a uniform, hashed from its name
+	using UniformId = std::uint32_t;
+
+	//Hashes a uniform name (FNV-1a), continuing from the given hash so names may be built in parts
+	constexpr UniformId uniform_id(const char *name, UniformId h = 2166136261u)
+	{
+		for (; *name; name++)
+			h = (h ^ UniformId(static_cast<unsigned char>(*name))) * 16777619u;
+		return h;
+	}
+
+	//Identifiers of the uniforms set by the renderer, hashed at compile time
+	namespace uniforms
+	{
+		constexpr UniformId projectionMatrix = uniform_id("projectionMatrix");
+		constexpr UniformId viewMatrix = uniform_id("viewMatrix");
+		constexpr UniformId modelMatrix = uniform_id("modelMatrix");
+		constexpr UniformId flatColour = uniform_id("flatColour");
+		constexpr UniformId shininess = uniform_id("shininess");
+		constexpr UniformId cameraPosition = uniform_id("cameraPosition");
+		constexpr UniformId texSampler = uniform_id("texSampler");
+		constexpr UniformId normalSampler = uniform_id("normalSampler");
+		constexpr UniformId cubeSampler = uniform_id("cubeSampler");
+		constexpr UniformId scale = uniform_id("scale");
+		constexpr UniformId offset = uniform_id("offset");
+		constexpr UniformId color = uniform_id("color");
+		constexpr UniformId position = uniform_id("position");
+		constexpr UniformId clusters = uniform_id("clusters");
+		constexpr UniformId clusterLights = uniform_id("clusterLights");
+		constexpr UniformId objectLights = uniform_id("objectLights");
+	}
+
 	class Shader
 	{
 	private:
@@ -16,10 +51,17 @@ namespace game
 		GLuint m_vertexShader;       //identifier for the vertex shader
 		GLuint m_fragmentShader;     //identifier for the fragment shader
 		GLuint m_programObject;      //identifier for the program- this is used when rendering.
+
+		//Location of every active uniform, sorted by identifier
+		std::vector<std::pair<UniformId, GLint>> m_uniforms;
+
 		GLuint loadShader(const char* filename, const GLenum type, std::string prepend = "") const;
 		std::string shaderInfoLog(const GLuint shader) const;
 		std::string programInfoLog(const GLuint program) const;
 
+		//Enumerates the active uniforms of the linked program into the location table
+		void reflect();
+
 	public:
 		Shader(void);
 		~Shader(void);
@@ -27,9 +69,11 @@ namespace game
 		//returns what we need for rendering
 		GLuint handle(void) const { return m_programObject; }
 
+		//Gets the location of the uniform with the given identifier, or -1 if it isn't active
+		GLint uniform(UniformId id) const;
+
 		//loads the shader program from two text files
 		bool load(const std::string name, const char* vertexFilename, const char* fragmentFilename,
 			std::string vertexPrepend = "", std::string fragmentPrepend = "");
 	};
 }
-
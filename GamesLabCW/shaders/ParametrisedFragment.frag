@@ -1,8 +1,7 @@
 //TEXTURED - should a texture be used?
 //NORMAL_MAPPED - should a normal map be used?
-//N_AMBIENT - number of ambient lights
-//N_DIRECTIONAL - number of directional lights
-//N_POINT - number of point lights
+//MAX_AMBIENT, MAX_DIRECTIONAL, MAX_POINT - capacity of the Lights block for each kind of light
+//CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z - screen tiles and depth slices of the light clusters
 
 in mat4 v_mModel;
 in vec3 v_vPosition;
@@ -17,15 +16,18 @@ uniform sampler2D normalSampler;
 uniform vec4 flatColour;
 uniform float shininess;
 uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
 uniform vec3 cameraPosition;
 
+//Point lights chosen for this object, one bit per light, low 32 lights first
+uniform uvec2 objectLights;
+
 struct AmbientLight
 {
 	vec3 colour;
 	float intensity;
 	bool on;
 };
-uniform AmbientLight ambientLights[N_AMBIENT];
 
 struct DirectionalLight
 {
@@ -34,7 +36,6 @@ struct DirectionalLight
 	vec3 direction;
 	bool on;
 };
-uniform DirectionalLight directionalLights[N_DIRECTIONAL];
 
 struct PointLight
 {
@@ -46,7 +47,26 @@ struct PointLight
 	float exponent;
 	bool on;
 };
-uniform PointLight pointLights[N_POINT];
+
+//Lights of the whole frame, shared by every program through one buffer
+layout(std140) uniform Lights
+{
+	int nAmbient;
+	int nDirectional;
+	int nPoint;
+
+	//Tiles per pixel and viewport origin, then near depth and slices per unit of log depth
+	vec4 clusterTiles;
+	vec4 clusterDepth;
+
+	AmbientLight ambientLights[MAX_AMBIENT];
+	DirectionalLight directionalLights[MAX_DIRECTIONAL];
+	PointLight pointLights[MAX_POINT];
+};
+
+//Span of clusterLights reaching each cluster, and the point lights of every span
+uniform usamplerBuffer clusters;
+uniform usamplerBuffer clusterLights;
 
 void main()
 {
@@ -79,7 +99,7 @@ void main()
 	vec3 specular = vec3(0.0);
 
 	//Apply ambient lights
-	for (int i = 0; i < N_AMBIENT; i++)
+	for (int i = 0; i < nAmbient; i++)
 	{
 		if (!ambientLights[i].on) 
 		{
@@ -89,7 +109,7 @@ void main()
 	}
 		
 	// Apply directional lights
-	for (int i = 0; i < N_DIRECTIONAL; i++)
+	for (int i = 0; i < nDirectional; i++)
 	{
 		if (!directionalLights[i].on) 
 		{
@@ -113,10 +133,19 @@ void main()
 		specular += directionalLights[i].intensity * spec * directionalLights[i].colour; 
 	}
 
-	// Apply point lights
-	for (int i = 0; i < N_POINT; i++)
+	// Find the cluster of this fragment, by screen tile and view depth
+	ivec2 tile = clamp(ivec2((gl_FragCoord.xy - clusterTiles.zw) * clusterTiles.xy), ivec2(0), ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+	float depth = -(viewMatrix * vec4(v_vPosition, 1.0)).z;
+	int slice = clamp(int(log(max(depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y), 0, CLUSTERS_Z - 1);
+	uvec2 cluster = texelFetch(clusters, (slice * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x).xy;
+
+	// Apply the point lights reaching this cluster which were chosen for this object
+	for (uint k = 0u; k < cluster.y; k++)
 	{
-		if (!pointLights[i].on) 
+		int i = int(texelFetch(clusterLights, int(cluster.x + k)).r);
+
+		uint chosen = i < 32 ? objectLights.x : objectLights.y;
+		if ((chosen & (1u << uint(i & 31))) == 0u || !pointLights[i].on) 
 		{
 			continue;
 		}